@@ -0,0 +1,76 @@
+#ifndef ICE_BENCHMARKS_BENCHMARK_HPP
+#define ICE_BENCHMARKS_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "multithreading/ice_scheduler.hpp"
+#include "multithreading/ice_worker_threads.hpp"
+
+namespace ice_benchmarks {
+
+// Fastest of repetitions runs of function, in milliseconds
+template <typename Function>
+double best_ms(int repetitions, Function function) {
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < repetitions; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    best = std::min(best, std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+  }
+  return best;
+}
+
+// Keeps the optimizer from dropping the computation of value: its address
+// escapes to a volatile, so whatever it points to has to be written.
+inline const void *volatile sink = nullptr;
+template <typename T>
+void keep(const T &value) {
+  sink = &value;
+}
+
+// The engine's threading: the calling thread owns slot 0, one worker per
+// remaining core (at least one). No Vulkan resources are handed out.
+class WorkerPool {
+ public:
+  explicit WorkerPool(std::size_t worker_count = default_worker_count())
+      : scheduler(worker_count) {
+    scheduler.register_thread(0, {});
+    workers.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+      workers.emplace_back(
+          ice_threading::WorkerThread(scheduler, i + 1, {}, {}));
+    }
+  }
+
+  ~WorkerPool() {
+    scheduler.stop();
+    for (std::jthread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  static std::size_t default_worker_count() {
+    const std::size_t hardware_threads = std::jthread::hardware_concurrency();
+    return hardware_threads > 1 ? hardware_threads - 1 : 1;
+  }
+
+  [[nodiscard]] std::size_t worker_count() const { return workers.size(); }
+
+  ice_threading::Scheduler scheduler;
+
+ private:
+  std::vector<std::jthread> workers;
+};
+}  // namespace ice_benchmarks
+
+#endif  // ICE_BENCHMARKS_BENCHMARK_HPP
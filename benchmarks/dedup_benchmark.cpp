@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "flat_hash_map.hpp"
+#include "obj_parsing.hpp"
+
+namespace {
+constexpr std::uint32_t GRID_SIDE = 1024;  // 2M triangles, 6M corners
+
+// The corners of a grid of quads in face order, as ObjMesh::parse_chunk
+// resolves them: every grid vertex is shared by up to six triangles
+std::vector<ice::obj::CornerKey> grid_corners() {
+  std::vector<ice::obj::CornerKey> corners;
+  corners.reserve(std::size_t{GRID_SIDE} * GRID_SIDE * 6);
+  const auto corner = [](std::uint32_t x, std::uint32_t y) {
+    const std::uint32_t index = y * (GRID_SIDE + 1) + x;
+    return ice::obj::CornerKey::make(index, index, 0, 1 + y % 2, 0);
+  };
+  for (std::uint32_t y = 0; y < GRID_SIDE; ++y) {
+    for (std::uint32_t x = 0; x < GRID_SIDE; ++x) {
+      corners.insert(corners.end(),
+                     {corner(x, y), corner(x + 1, y), corner(x + 1, y + 1),
+                      corner(x, y), corner(x + 1, y + 1), corner(x, y + 1)});
+    }
+  }
+  return corners;
+}
+
+using FlatMap = ice::FlatHashMap<ice::obj::CornerKey, std::uint32_t,
+                                 ice::obj::CornerKeyHash>;
+using NodeMap = std::unordered_map<ice::obj::CornerKey, std::uint32_t,
+                                   ice::obj::CornerKeyHash>;
+
+// the vertex id of corner, and whether it was new
+std::pair<std::uint32_t, bool> insert(FlatMap &map,
+                                      const ice::obj::CornerKey &corner,
+                                      std::uint32_t id) {
+  const auto [stored, inserted] = map.try_emplace(corner, id);
+  return {stored, inserted};
+}
+std::pair<std::uint32_t, bool> insert(NodeMap &map,
+                                      const ice::obj::CornerKey &corner,
+                                      std::uint32_t id) {
+  const auto [entry, inserted] = map.try_emplace(corner, id);
+  return {entry->second, inserted};
+}
+
+// Vertex ids of corners, deduplicated in a Map reserved like parse_chunk
+// reserves its history
+template <typename Map>
+std::size_t deduplicate(const std::vector<ice::obj::CornerKey> &corners,
+                        std::vector<std::uint32_t> &indices) {
+  Map history;
+  history.reserve(corners.size() / 4);
+  std::uint32_t vertex_count = 0;
+  indices.clear();
+  for (const ice::obj::CornerKey &corner : corners) {
+    const auto [id, inserted] = insert(history, corner, vertex_count);
+    indices.push_back(id);
+    vertex_count += inserted ? 1 : 0;
+  }
+  return vertex_count;
+}
+}  // namespace
+
+// OBJ corner deduplication with the flat map against std::unordered_map,
+// both keyed on the packed CornerKey
+int main() {
+  const std::vector<ice::obj::CornerKey> corners = grid_corners();
+  std::cout << corners.size() << " corners\n";
+
+  std::vector<std::uint32_t> flat_indices;
+  std::vector<std::uint32_t> node_indices;
+  std::size_t flat_vertices = 0;
+  std::size_t node_vertices = 0;
+  const double flat = ice_benchmarks::best_ms(5, [&] {
+    flat_vertices = deduplicate<FlatMap>(corners, flat_indices);
+  });
+  const double node = ice_benchmarks::best_ms(5, [&] {
+    node_vertices = deduplicate<NodeMap>(corners, node_indices);
+  });
+
+  if (flat_vertices != node_vertices || flat_indices != node_indices) {
+    std::cerr << "the maps deduplicate differently\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << flat_vertices << " vertices: FlatHashMap " << std::fixed
+            << std::setprecision(1) << std::setw(7) << flat
+            << " ms, std::unordered_map " << std::setw(7) << node << " ms ("
+            << node / flat << "x)\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "benchmark.hpp"
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "obj_parsing.hpp"
+
+namespace {
+constexpr std::uint32_t GRID_SIDE = 512;  // 512^2 quads, 524288 triangles
+
+struct Files {
+  std::string obj, mtl;
+};
+
+// A textured grid of quads, rows alternating between two materials
+Files write_grid(const std::filesystem::path &directory) {
+  const Files files = {.obj = (directory / "ice_bench_grid.obj").string(),
+                       .mtl = (directory / "ice_bench_grid.mtl").string()};
+  std::ofstream mtl(files.mtl);
+  mtl << "newmtl red\nKd 1.0 0.0 0.0\nnewmtl green\nKd 0.0 1.0 0.0\n";
+
+  std::ofstream obj(files.obj);
+  obj << "mtllib ice_bench_grid.mtl\n" << std::fixed << std::setprecision(6);
+  for (std::uint32_t y = 0; y <= GRID_SIDE; ++y) {
+    for (std::uint32_t x = 0; x <= GRID_SIDE; ++x) {
+      obj << "v " << x * 0.01f << ' '
+          << 0.001f * static_cast<float>((x * y) % 97) << ' ' << y * 0.01f
+          << "\nvt " << static_cast<float>(x) / GRID_SIDE << ' '
+          << static_cast<float>(y) / GRID_SIDE << '\n';
+    }
+  }
+  obj << "vn 0.0 1.0 0.0\n";
+  for (std::uint32_t y = 0; y < GRID_SIDE; ++y) {
+    obj << (y % 2 == 0 ? "usemtl red\n" : "usemtl green\n");
+    for (std::uint32_t x = 0; x < GRID_SIDE; ++x) {
+      const std::uint32_t corner = y * (GRID_SIDE + 1) + x + 1;
+      const std::uint32_t above = corner + GRID_SIDE + 1;
+      obj << 'f';
+      for (const std::uint32_t position : {corner, corner + 1, above + 1,
+                                           above}) {
+        obj << ' ' << position << '/' << position << "/1";
+      }
+      obj << '\n';
+    }
+  }
+  return files;
+}
+
+// What the loader did before the mapped parser: a stream and a string per
+// line, std::stof and std::stol per number
+std::size_t stream_tokenize(const std::string &path, float &checksum) {
+  std::ifstream file(path);
+  std::size_t corners = 0;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream words(line);
+    std::string keyword;
+    words >> keyword;
+    if (keyword == "v" || keyword == "vt" || keyword == "vn") {
+      for (std::string number; words >> number;) {
+        checksum += std::stof(number);
+      }
+    } else if (keyword == "f") {
+      for (std::string corner; words >> corner;) {
+        checksum += static_cast<float>(std::stol(corner));
+        ++corners;
+      }
+    }
+  }
+  return corners;
+}
+
+// the same walk over the mapped file with the in-place tokenizer
+std::size_t mapped_tokenize(const std::string &path, float &checksum) {
+  const ice::MappedFile file(path.c_str());
+  std::string_view text = file.view();
+  std::size_t corners = 0;
+  while (!text.empty()) {
+    std::string_view line = ice::obj::next_line(text);
+    const std::string_view keyword = ice::obj::next_token(line);
+    if (keyword == "v" || keyword == "vt" || keyword == "vn") {
+      for (std::string_view number = ice::obj::next_token(line);
+           !number.empty(); number = ice::obj::next_token(line)) {
+        checksum += ice::obj::parse_float(number);
+      }
+    } else if (keyword == "f") {
+      for (std::string_view corner = ice::obj::next_token(line);
+           !corner.empty(); corner = ice::obj::next_token(line)) {
+        checksum +=
+            static_cast<float>(ice::obj::parse_corner(corner).position);
+        ++corners;
+      }
+    }
+  }
+  return corners;
+}
+
+// Times ObjMesh::load parsing the text (the .icemesh cache removed first)
+double time_parse(const Files &files, ice_threading::Scheduler *scheduler,
+                  std::size_t &index_count) {
+  return ice_benchmarks::best_ms(3, [&] {
+    std::filesystem::remove(*ice::mesh_cache_path(files.obj));
+    ice::ObjMesh mesh;
+    mesh.load(files.obj.c_str(), files.mtl.c_str(), glm::mat4(1.0f),
+              scheduler);
+    index_count = mesh.index_data().size();
+  });
+}
+}  // namespace
+
+// The OBJ loader on a generated grid, or on the files given as
+// obj_parser_benchmark <obj> <mtl>: tokenizing with streams against the
+// mapped tokenizer, then whole loads, serial and chunked on the workers,
+// and from the .icemesh cache.
+int main(int argc, char **argv) {
+  const bool generated = argc < 3;
+  const std::filesystem::path temp = std::filesystem::temp_directory_path();
+  const Files files = generated ? write_grid(temp)
+                                : Files{.obj = argv[1], .mtl = argv[2]};
+  ice::set_mesh_cache_directory(temp / "ice_bench_mesh_cache");
+  std::cout << files.obj << ", " << std::fixed << std::setprecision(1)
+            << static_cast<double>(std::filesystem::file_size(files.obj)) /
+                   (1 << 20)
+            << " MiB\n";
+
+  float stream_checksum = 0.0f;
+  float mapped_checksum = 0.0f;
+  std::size_t stream_corners = 0;
+  std::size_t mapped_corners = 0;
+  const double stream = ice_benchmarks::best_ms(3, [&] {
+    stream_checksum = 0.0f;
+    stream_corners = stream_tokenize(files.obj, stream_checksum);
+  });
+  const double mapped = ice_benchmarks::best_ms(3, [&] {
+    mapped_checksum = 0.0f;
+    mapped_corners = mapped_tokenize(files.obj, mapped_checksum);
+  });
+  if (stream_corners != mapped_corners ||
+      stream_checksum != mapped_checksum) {
+    std::cerr << "the tokenizers disagree\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "tokenize: streams " << std::setw(8) << stream
+            << " ms, mapped from_chars " << std::setw(8) << mapped << " ms ("
+            << stream / mapped << "x)\n";
+
+  ice_benchmarks::WorkerPool pool;
+  std::size_t serial_indices = 0;
+  std::size_t parallel_indices = 0;
+  const double serial = time_parse(files, nullptr, serial_indices);
+  const double parallel = time_parse(files, &pool.scheduler, parallel_indices);
+  if (serial_indices != parallel_indices) {
+    std::cerr << "the serial and chunked loads disagree\n";
+    return EXIT_FAILURE;
+  }
+  const double cached = ice_benchmarks::best_ms(3, [&] {
+    ice::ObjMesh mesh;
+    mesh.load(files.obj.c_str(), files.mtl.c_str(), glm::mat4(1.0f));
+    ice_benchmarks::keep(mesh);
+  });
+  const double million_triangles =
+      static_cast<double>(serial_indices) / 3.0 / 1e6;
+  std::cout << "load: serial " << std::setw(8) << serial << " ms ("
+            << serial / million_triangles << " ms per M triangles), "
+            << pool.worker_count() << " workers " << std::setw(8) << parallel
+            << " ms, cached " << std::setw(6) << std::setprecision(2)
+            << cached << " ms\n";
+
+  std::filesystem::remove_all(temp / "ice_bench_mesh_cache");
+  if (generated) {
+    std::filesystem::remove(files.obj);
+    std::filesystem::remove(files.mtl);
+  }
+  return EXIT_SUCCESS;
+}
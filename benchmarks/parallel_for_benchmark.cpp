@@ -0,0 +1,77 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "multithreading/ice_parallel.hpp"
+
+namespace {
+constexpr std::size_t ELEMENT_COUNT = std::size_t{1} << 22;
+
+// a few dozen cycles per element, like building a model transform
+void compute(std::vector<float> &values, std::size_t first, std::size_t last) {
+  for (std::size_t i = first; i < last; ++i) {
+    const auto x = static_cast<float>(i);
+    values[i] = std::sqrt(x) * std::sin(x);
+  }
+}
+}  // namespace
+
+// parallel_for against the same loop on the calling thread, for several
+// grain sizes, and parallel_reduce checked against the closed form
+int main() {
+  ice_benchmarks::WorkerPool pool;
+  std::cout << pool.worker_count() << " workers, " << ELEMENT_COUNT
+            << " elements\n"
+            << std::fixed << std::setprecision(2);
+
+  std::vector<float> values(ELEMENT_COUNT);
+  const double serial = ice_benchmarks::best_ms(5, [&] {
+    compute(values, 0, ELEMENT_COUNT);
+    ice_benchmarks::keep(values);
+  });
+  std::cout << "serial:                 " << std::setw(8) << serial
+            << " ms\n";
+
+  for (const std::size_t grain_size : {256U, 4096U, 65536U}) {
+    const double parallel = ice_benchmarks::best_ms(5, [&] {
+      ice_threading::parallel_for(
+          &pool.scheduler, 0, ELEMENT_COUNT, grain_size,
+          [&](std::size_t first, std::size_t last) {
+            compute(values, first, last);
+          });
+      ice_benchmarks::keep(values);
+    });
+    std::cout << "parallel_for, grain " << std::setw(5) << grain_size
+              << ": " << std::setw(8) << parallel << " ms, speedup "
+              << serial / parallel << "x\n";
+  }
+
+  double sum = 0.0;
+  const double reduce = ice_benchmarks::best_ms(5, [&] {
+    sum = ice_threading::parallel_reduce(
+        &pool.scheduler, 0, ELEMENT_COUNT, 4096, 0.0,
+        [](std::size_t first, std::size_t last) {
+          double partial = 0.0;
+          for (std::size_t i = first; i < last; ++i) {
+            partial += static_cast<double>(i);
+          }
+          return partial;
+        },
+        [](double accumulated, double partial) {
+          return accumulated + partial;
+        });
+  });
+  const double expected = static_cast<double>(ELEMENT_COUNT) *
+                          static_cast<double>(ELEMENT_COUNT - 1) / 2.0;
+  if (sum != expected) {
+    std::cerr << "parallel_reduce: " << sum << " instead of " << expected
+              << "\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "parallel_reduce (sum):  " << std::setw(8) << reduce
+            << " ms\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,47 @@
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "benchmark.hpp"
+
+namespace {
+std::atomic<std::size_t> executed{0};
+
+// as little work as a job can do, so the scheduling is what is timed
+class EmptyJob : public ice_threading::Job {
+ public:
+  void execute(vk::CommandBuffer, vk::Queue) final {
+    executed.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+}  // namespace
+
+// Throughput of independent trivial jobs submitted from the main thread, as
+// make_assets does, and the cost of each job. Startup used to be quadratic
+// in the job count with the linked-list WorkQueue.
+int main() {
+  ice_benchmarks::WorkerPool pool;
+  std::cout << pool.worker_count() << " workers\n" << std::fixed;
+
+  for (const std::size_t job_count : {10U, 1000U, 100000U, 1000000U}) {
+    executed = 0;
+    const double ms = ice_benchmarks::best_ms(5, [&] {
+      ice_threading::JobCounter counter;
+      for (std::size_t i = 0; i < job_count; ++i) {
+        pool.scheduler.submit(new EmptyJob, &counter);
+      }
+      pool.scheduler.wait(counter);
+    });
+    if (executed != job_count * 5) {
+      std::cerr << executed.load() << " of " << job_count * 5
+                << " jobs ran\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << std::setw(8) << job_count << " jobs: " << std::setw(9)
+              << std::setprecision(3) << ms << " ms, " << std::setw(6)
+              << std::setprecision(1)
+              << ms * 1e6 / static_cast<double>(job_count) << " ns per job\n";
+  }
+  return EXIT_SUCCESS;
+}
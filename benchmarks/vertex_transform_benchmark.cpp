@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "vertex_transform.hpp"
+
+namespace {
+constexpr std::size_t VERTEX_COUNT = std::size_t{1} << 20;
+}  // namespace
+
+// The batch kernel compiled in (see ICE_ENABLE_AVX2) against the per-vertex
+// glm products the loaders used before, on 1M positions and normals
+int main() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+  glm::mat4 matrix(1.0f);
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 3; ++row) {
+      matrix[column][row] = value(rng);
+    }
+  }
+  const glm::mat3 normal_matrix(matrix);
+
+  std::vector<glm::vec3> source(VERTEX_COUNT);
+  for (glm::vec3 &vector : source) {
+    vector = {value(rng), value(rng), value(rng)};
+  }
+
+  std::vector<glm::vec3> vectors;
+  const double scalar_points = ice_benchmarks::best_ms(10, [&] {
+    vectors = source;
+    for (glm::vec3 &point : vectors) {
+      point = glm::vec3(matrix * glm::vec4(point, 1.0f));
+    }
+    ice_benchmarks::keep(vectors);
+  });
+  const double batch_points = ice_benchmarks::best_ms(10, [&] {
+    vectors = source;
+    ice::transform_points(matrix, vectors);
+    ice_benchmarks::keep(vectors);
+  });
+  const double scalar_directions = ice_benchmarks::best_ms(10, [&] {
+    vectors = source;
+    for (glm::vec3 &direction : vectors) {
+      direction = normal_matrix * direction;
+    }
+    ice_benchmarks::keep(vectors);
+  });
+  const double batch_directions = ice_benchmarks::best_ms(10, [&] {
+    vectors = source;
+    ice::transform_directions(normal_matrix, vectors);
+    ice_benchmarks::keep(vectors);
+  });
+  // the copy of source is part of every timing
+  const double copy = ice_benchmarks::best_ms(10, [&] {
+    vectors = source;
+    ice_benchmarks::keep(vectors);
+  });
+
+  std::cout << std::fixed << std::setprecision(3)
+            << ice::vertex_transform_kernel() << " kernel, " << VERTEX_COUNT
+            << " vertices (copy " << copy << " ms)\n";
+  std::cout << "points:     per vertex " << std::setw(7) << scalar_points
+            << " ms, batch " << std::setw(7) << batch_points << " ms\n";
+  std::cout << "directions: per vertex " << std::setw(7) << scalar_directions
+            << " ms, batch " << std::setw(7) << batch_directions << " ms\n";
+  return EXIT_SUCCESS;
+}
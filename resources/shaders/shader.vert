@@ -6,8 +6,14 @@ layout(binding = 0) uniform UBO {
 	mat4 viewProjection;
 } cameraData;
 
+// normal is the inverse transpose of model, right for non-uniform scales too
+struct Instance {
+	mat4 model;
+	mat4 normal;
+};
+
 layout(std140, binding = 1) readonly buffer storageBuffer {
-	mat4 model[];
+	Instance instances[];
 } ObjectData;
 
 layout(location = 0) in vec3 vertexPosition;
@@ -20,9 +26,9 @@ layout(location = 1) out vec2 fragTexCoord;
 layout(location = 2) out vec3 fragNormal;
 
 void main() {
-	gl_Position = cameraData.viewProjection * ObjectData.model[gl_InstanceIndex] * vec4(vertexPosition, 1.0);
+	gl_Position = cameraData.viewProjection * ObjectData.instances[gl_InstanceIndex].model * vec4(vertexPosition, 1.0);
 	fragColor = vertexColor;
 	fragTexCoord = vertexTexCoord;
 	/* w = 0 to remove translation, only take first 3 components*/
-	fragNormal = normalize((ObjectData.model[gl_InstanceIndex] * vec4(vertexNormal, 0.0)).xyz);
+	fragNormal = normalize((ObjectData.instances[gl_InstanceIndex].normal * vec4(vertexNormal, 0.0)).xyz);
 }
\ No newline at end of file
@@ -95,10 +95,7 @@ inline void end_job(vk::CommandBuffer command_buffer,
                     vk::Queue submission_queue) {
   command_buffer.end();
 
-  const vk::SubmitInfo submit_info{.commandBufferCount = 1,
-                                   .pCommandBuffers = &command_buffer};
-  auto result = submission_queue.submit(1, &submit_info, nullptr);
-  submission_queue.waitIdle();
+  auto result = submit_and_wait(command_buffer, submission_queue);
 }
 }  // namespace ice
 
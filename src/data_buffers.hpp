@@ -1,6 +1,9 @@
 #ifndef DATA_BUFFERS_HPP
 #define DATA_BUFFERS_HPP
+#include <span>
+
 #include "config.hpp"
+#include "queue.hpp"
 
 namespace ice {
 
@@ -116,22 +119,17 @@ inline vk::Result copy_buffer(const BufferBundle &src_buffer,
 
   command_buffer.end();
 
-  const vk::SubmitInfo submit_info{.commandBufferCount = 1,
-                                   .pCommandBuffers = &command_buffer};
-
-  const vk::Result result = queue.submit(1, &submit_info, nullptr);
-  queue.waitIdle();
-  return result;
+  return submit_and_wait(command_buffer, queue);
 }
 
+// Creates a host visible buffer holding a copy of data, the source of an
+// upload to device local memory.
 template <typename T>
-inline BufferBundle create_device_local_buffer(
-    vk::PhysicalDevice physical_device, vk::Device device,
-    vk::CommandBuffer command_buffer, vk::Queue queue,
-    vk::BufferUsageFlagBits usage_bit, const std::vector<T> &data) {
-  // host local buffer initialization
-  BufferCreationInput buffer_input = {
-      .size = data.size() * sizeof(T),
+inline BufferBundle make_staging_buffer(vk::PhysicalDevice physical_device,
+                                        vk::Device device,
+                                        std::span<const T> data) {
+  const BufferCreationInput buffer_input = {
+      .size = data.size_bytes(),
       .usage = vk::BufferUsageFlagBits::eTransferSrc,
       .logical_device = device,
       .physical_device = physical_device};
@@ -143,15 +141,68 @@ inline BufferBundle create_device_local_buffer(
   memcpy(memory_location, data.data(), buffer_input.size);
   device.unmapMemory(staging_buffer_bundle.buffer_memory);
 
+  return staging_buffer_bundle;
+}
+
+template <typename T>
+inline BufferBundle make_staging_buffer(vk::PhysicalDevice physical_device,
+                                        vk::Device device,
+                                        const std::vector<T> &data) {
+  return make_staging_buffer(physical_device, device,
+                             std::span<const T>(data));
+}
+
+// Creates a device local buffer of size bytes and records the copy from the
+// staging buffer into command_buffer, which must be recording. The staging
+// buffer has to stay alive until the commands executed.
+inline BufferBundle record_device_local_copy(
+    vk::PhysicalDevice physical_device, vk::Device device,
+    vk::CommandBuffer command_buffer, vk::BufferUsageFlagBits usage_bit,
+    const BufferBundle &staging_buffer_bundle, vk::DeviceSize size) {
+  const BufferCreationInput buffer_input = {
+      .size = size,
+      .usage = vk::BufferUsageFlagBits::eTransferDst | usage_bit,
+      .memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+      .logical_device = device,
+      .physical_device = physical_device};
+  const ice::BufferBundle buffer_bundle = create_buffer(buffer_input);
+
+  const vk::BufferCopy copy_region{
+      .srcOffset = 0, .dstOffset = 0, .size = size};
+  command_buffer.copyBuffer(staging_buffer_bundle.buffer, buffer_bundle.buffer,
+                            1, &copy_region);
+
+  return buffer_bundle;
+}
+
+inline void destroy_buffer(vk::Device device,
+                           const BufferBundle &buffer_bundle) {
+  device.destroyBuffer(buffer_bundle.buffer);
+  device.freeMemory(buffer_bundle.buffer_memory);
+}
+
+template <typename T>
+inline BufferBundle create_device_local_buffer(
+    vk::PhysicalDevice physical_device, vk::Device device,
+    vk::CommandBuffer command_buffer, vk::Queue queue,
+    vk::BufferUsageFlagBits usage_bit, std::span<const T> data) {
+  // host local buffer initialization
+  const ice::BufferBundle staging_buffer_bundle =
+      make_staging_buffer(physical_device, device, data);
+
   // device local buffer initialization
-  buffer_input.usage = vk::BufferUsageFlagBits::eTransferDst | usage_bit;
-  buffer_input.memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+  const vk::DeviceSize size = data.size_bytes();
+  const BufferCreationInput buffer_input = {
+      .size = size,
+      .usage = vk::BufferUsageFlagBits::eTransferDst | usage_bit,
+      .memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+      .logical_device = device,
+      .physical_device = physical_device};
   ice::BufferBundle buffer_bundle = create_buffer(buffer_input);
 
   // copy
-  const vk::Result result =
-      copy_buffer(staging_buffer_bundle, buffer_bundle, buffer_input.size,
-                  queue, command_buffer);
+  const vk::Result result = copy_buffer(staging_buffer_bundle, buffer_bundle,
+                                        size, queue, command_buffer);
   if (result != vk::Result::eSuccess) {
 #ifndef NDEBUG
     std::cerr << std::format("{} copy operation creation failed!\n",
@@ -160,11 +211,19 @@ inline BufferBundle create_device_local_buffer(
   }
 
   // destroy staging buffer
-  device.destroyBuffer(staging_buffer_bundle.buffer);
-  device.freeMemory(staging_buffer_bundle.buffer_memory);
+  destroy_buffer(device, staging_buffer_bundle);
 
   return buffer_bundle;
 }
+
+template <typename T>
+inline BufferBundle create_device_local_buffer(
+    vk::PhysicalDevice physical_device, vk::Device device,
+    vk::CommandBuffer command_buffer, vk::Queue queue,
+    vk::BufferUsageFlagBits usage_bit, const std::vector<T> &data) {
+  return create_device_local_buffer(physical_device, device, command_buffer,
+                                    queue, usage_bit, std::span<const T>(data));
+}
 }  // namespace ice
 
 #endif  // DATA_BUFFERS_HPP
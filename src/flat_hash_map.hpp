@@ -0,0 +1,115 @@
+#ifndef FLAT_HASH_MAP_HPP
+#define FLAT_HASH_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ice {
+
+/**
+ * Open-addressing hash map with linear probing. Entries live in one array,
+ * so a lookup touches a couple of neighbouring slots instead of chasing a
+ * node per entry like std::unordered_map, and inserting never allocates
+ * once reserve() was given the expected size. Only supports inserting, no
+ * erase. Key and Value must be cheap to copy and default constructible.
+ */
+template <typename Key, typename Value, typename Hash>
+class FlatHashMap {
+ public:
+  FlatHashMap() = default;
+
+  // Makes room for count entries without rehashing.
+  void reserve(std::size_t count) {
+    const std::size_t needed = capacity_for(count);
+    if (needed > slots.size()) {
+      rehash(needed);
+    }
+  }
+
+  // Inserts {key, value} if key is not present yet. Returns the stored value
+  // and whether it was inserted.
+  std::pair<Value &, bool> try_emplace(const Key &key, const Value &value) {
+    if (capacity_for(entry_count + 1) > slots.size()) {
+      rehash(capacity_for(entry_count + 1) * 2);
+    }
+    std::size_t index = Hash{}(key) & (slots.size() - 1);
+    while (occupied[index] != 0) {
+      if (slots[index].key == key) {
+        return {slots[index].value, false};
+      }
+      index = (index + 1) & (slots.size() - 1);
+    }
+    occupied[index] = 1;
+    slots[index] = {key, value};
+    ++entry_count;
+    return {slots[index].value, true};
+  }
+
+  // nullptr if key is not present
+  [[nodiscard]] const Value *find(const Key &key) const {
+    if (slots.empty()) {
+      return nullptr;
+    }
+    std::size_t index = Hash{}(key) & (slots.size() - 1);
+    while (occupied[index] != 0) {
+      if (slots[index].key == key) {
+        return &slots[index].value;
+      }
+      index = (index + 1) & (slots.size() - 1);
+    }
+    return nullptr;
+  }
+
+  [[nodiscard]] std::size_t size() const { return entry_count; }
+  [[nodiscard]] bool empty() const { return entry_count == 0; }
+
+  // Removes every entry and keeps the capacity.
+  void clear() {
+    std::fill(occupied.begin(), occupied.end(), std::uint8_t{0});
+    entry_count = 0;
+  }
+
+ private:
+  struct Slot {
+    Key key;
+    Value value;
+  };
+
+  // power of two that keeps the load at or below 3/4
+  static std::size_t capacity_for(std::size_t count) {
+    std::size_t capacity = 16;
+    while (capacity * 3 < count * 4) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  void rehash(std::size_t capacity) {
+    std::vector<Slot> old_slots = std::exchange(slots, {});
+    std::vector<std::uint8_t> old_occupied = std::exchange(occupied, {});
+    slots.resize(capacity);
+    occupied.assign(capacity, 0);
+
+    for (std::size_t i = 0; i < old_slots.size(); ++i) {
+      if (old_occupied[i] == 0) {
+        continue;
+      }
+      std::size_t index = Hash{}(old_slots[i].key) & (capacity - 1);
+      while (occupied[index] != 0) {
+        index = (index + 1) & (capacity - 1);
+      }
+      occupied[index] = 1;
+      slots[index] = old_slots[i];
+    }
+  }
+
+  std::vector<Slot> slots;
+  std::vector<std::uint8_t> occupied;
+  std::size_t entry_count{0};
+};
+}  // namespace ice
+
+#endif  // FLAT_HASH_MAP_HPP
@@ -22,6 +22,19 @@ struct GameObject {
   glm::mat4 model;
 };
 
+// One instance of the model SSBO (shader.vert). Normals are transformed by
+// the inverse transpose of model, which only equals model itself when it
+// scales uniformly.
+struct InstanceTransform {
+  glm::mat4 model;
+  glm::mat4 normal;
+};
+
+inline InstanceTransform make_instance_transform(const glm::mat4 &model) {
+  return {.model = model,
+          .normal = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))))};
+}
+
 //--------- Assets -------------//
 enum class MeshTypes { GROUND, GIRL, SKULL };
 
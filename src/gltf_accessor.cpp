@@ -0,0 +1,353 @@
+#include "gltf_accessor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#define ICE_ACCESSOR_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ICE_ACCESSOR_SSE
+#include <emmintrin.h>
+#endif
+
+namespace ice {
+
+namespace {
+// glTF data has no alignment guarantees inside interleaved views
+template <typename T>
+T load(const std::byte *data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+// glTF normalization: c / max for unsigned, max(c / max, -1) for signed.
+// Normalized uint and float accessors are invalid, they are read by value.
+template <typename T>
+float to_float(const std::byte *data, bool normalized) {
+  const auto value = static_cast<float>(load<T>(data));
+  if constexpr (std::is_integral_v<T> && sizeof(T) < 4) {
+    constexpr float SCALE = 1.0f / std::numeric_limits<T>::max();
+    return normalized ? std::max(value * SCALE, -1.0f) : value;
+  }
+  return value;
+}
+
+// count elements, stride bytes apart, to out_components floats each
+template <typename T>
+void decode_elements(const std::byte *src, std::size_t stride,
+                     std::size_t count, int components, bool normalized,
+                     float *out, int out_components) {
+  const int shared = std::min(components, out_components);
+  for (std::size_t i = 0; i < count; ++i, src += stride) {
+    float *element = out + i * out_components;
+    for (int c = 0; c < shared; ++c) {
+      element[c] = to_float<T>(src + c * sizeof(T), normalized);
+    }
+    for (int c = shared; c < out_components; ++c) {
+      element[c] = 0.0f;
+    }
+  }
+}
+
+template <typename T>
+uint32_t to_index(const std::byte *data) {
+  return load<T>(data);
+}
+
+struct ComponentFormat {
+  int type;
+  std::size_t size;
+  void (*decode)(const std::byte *src, std::size_t stride, std::size_t count,
+                 int components, bool normalized, float *out,
+                 int out_components);
+  // null for types indices can not have
+  uint32_t (*index)(const std::byte *);
+};
+
+// every component type of the spec
+constexpr std::array<ComponentFormat, 6> COMPONENT_FORMATS = {{
+    {TINYGLTF_COMPONENT_TYPE_BYTE, 1, decode_elements<int8_t>, nullptr},
+    {TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 1, decode_elements<uint8_t>,
+     to_index<uint8_t>},
+    {TINYGLTF_COMPONENT_TYPE_SHORT, 2, decode_elements<int16_t>, nullptr},
+    {TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 2, decode_elements<uint16_t>,
+     to_index<uint16_t>},
+    {TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, 4, decode_elements<uint32_t>,
+     to_index<uint32_t>},
+    {TINYGLTF_COMPONENT_TYPE_FLOAT, 4, decode_elements<float>, nullptr},
+}};
+
+const ComponentFormat *find_format(int type) {
+  for (const ComponentFormat &format : COMPONENT_FORMATS) {
+    if (format.type == type) {
+      return &format;
+    }
+  }
+  return nullptr;
+}
+
+// whether count elements, stride bytes apart from offset on, end within
+// length bytes (without overflowing on hostile counts)
+bool fits(std::size_t offset, std::size_t count, std::size_t stride,
+          std::size_t element_size, std::size_t length) {
+  if (offset > length) {
+    return false;
+  }
+  if (count == 0) {
+    return true;
+  }
+  if (element_size > length - offset) {
+    return false;
+  }
+  return count - 1 <= (length - offset - element_size) / stride;
+}
+
+// count elements at byte_offset into a buffer view, null unless all of them
+// are inside the view and the view inside its buffer
+const std::byte *view_data(const tinygltf::Model &model, int buffer_view,
+                           std::size_t byte_offset, std::size_t count,
+                           std::size_t stride, std::size_t element_size) {
+  if (buffer_view < 0 ||
+      static_cast<std::size_t>(buffer_view) >= model.bufferViews.size()) {
+    return nullptr;
+  }
+  const tinygltf::BufferView &view = model.bufferViews[buffer_view];
+  if (view.buffer < 0 ||
+      static_cast<std::size_t>(view.buffer) >= model.buffers.size()) {
+    return nullptr;
+  }
+  const std::vector<unsigned char> &data = model.buffers[view.buffer].data;
+  if (!fits(view.byteOffset, 1, 1, view.byteLength, data.size()) ||
+      !fits(byte_offset, count, stride, element_size, view.byteLength)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const std::byte *>(data.data()) + view.byteOffset +
+         byte_offset;
+}
+
+// out[i] = src[i] * scale
+void convert_uint16(const std::byte *src, std::size_t count, float scale,
+                    float *out) {
+  std::size_t i = 0;
+#if defined(ICE_ACCESSOR_AVX2)
+  const __m256 factor = _mm256_set1_ps(scale);
+  for (; i + 8 <= count; i += 8) {
+    const __m128i values =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    const __m256 widened = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(values));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(widened, factor));
+  }
+#elif defined(ICE_ACCESSOR_SSE)
+  const __m128 factor = _mm_set1_ps(scale);
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= count; i += 8) {
+    const __m128i values =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    const __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, zero));
+    const __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(values, zero));
+    _mm_storeu_ps(out + i, _mm_mul_ps(low, factor));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(high, factor));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = static_cast<float>(load<uint16_t>(src + i * 2)) * scale;
+  }
+}
+
+// out[i] = src[i], zero extended
+void widen_uint16(const std::byte *src, std::size_t count, uint32_t *out) {
+  std::size_t i = 0;
+#if defined(ICE_ACCESSOR_AVX2)
+  for (; i + 8 <= count; i += 8) {
+    const __m128i values =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm256_cvtepu16_epi32(values));
+  }
+#elif defined(ICE_ACCESSOR_SSE)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= count; i += 8) {
+    const __m128i values =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 2));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_unpacklo_epi16(values, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4),
+                     _mm_unpackhi_epi16(values, zero));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = load<uint16_t>(src + i * 2);
+  }
+}
+
+// Calls substitute(element, sparse value) for the sparse elements in
+// [first, last)
+template <typename Substitute>
+void for_each_sparse(const GltfAccessorView &view, std::size_t first,
+                     std::size_t last, std::size_t element_size,
+                     const Substitute &substitute) {
+  if (view.sparse_count == 0) {
+    return;
+  }
+  const ComponentFormat &index_format = *find_format(view.sparse_index_type);
+  const auto sparse_index = [&](std::size_t k) -> std::size_t {
+    return index_format.index(view.sparse_indices + k * index_format.size);
+  };
+
+  // indices ascend, skip to the first one of the range
+  std::size_t low = 0;
+  std::size_t high = view.sparse_count;
+  while (low < high) {
+    const std::size_t middle = low + (high - low) / 2;
+    if (sparse_index(middle) < first) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  for (std::size_t k = low; k < view.sparse_count; ++k) {
+    const std::size_t element = sparse_index(k);
+    if (element >= last) {
+      break;
+    }
+    substitute(element, view.sparse_values + k * element_size);
+  }
+}
+}  // namespace
+
+std::optional<GltfAccessorView> view_accessor(
+    const tinygltf::Model &model, const tinygltf::Accessor &accessor) {
+  const ComponentFormat *format = find_format(accessor.componentType);
+  const int components = tinygltf::GetNumComponentsInType(accessor.type);
+  if (format == nullptr || components <= 0) {
+    return std::nullopt;
+  }
+  const std::size_t element_size = format->size * components;
+
+  GltfAccessorView view{.count = accessor.count,
+                        .component_type = accessor.componentType,
+                        .components = components,
+                        .normalized = accessor.normalized};
+
+  // without a buffer view the accessor is zeros (plus its sparse values)
+  if (accessor.bufferView >= 0) {
+    const tinygltf::BufferView *buffer_view =
+        static_cast<std::size_t>(accessor.bufferView) <
+                model.bufferViews.size()
+            ? &model.bufferViews[accessor.bufferView]
+            : nullptr;
+    if (buffer_view == nullptr) {
+      return std::nullopt;
+    }
+    view.stride = buffer_view->byteStride != 0 ? buffer_view->byteStride
+                                               : element_size;
+    if (view.stride < element_size) {
+      return std::nullopt;
+    }
+    view.data = view_data(model, accessor.bufferView, accessor.byteOffset,
+                          accessor.count, view.stride, element_size);
+    if (view.data == nullptr) {
+      return std::nullopt;
+    }
+  }
+
+  if (accessor.sparse.isSparse && accessor.sparse.count > 0) {
+    const auto &sparse = accessor.sparse;
+    const ComponentFormat *index_format =
+        find_format(sparse.indices.componentType);
+    if (index_format == nullptr || index_format->index == nullptr) {
+      return std::nullopt;
+    }
+    view.sparse_count = static_cast<std::size_t>(sparse.count);
+    view.sparse_index_type = sparse.indices.componentType;
+    view.sparse_indices = view_data(
+        model, sparse.indices.bufferView, sparse.indices.byteOffset,
+        view.sparse_count, index_format->size, index_format->size);
+    view.sparse_values =
+        view_data(model, sparse.values.bufferView, sparse.values.byteOffset,
+                  view.sparse_count, element_size, element_size);
+    if (view.sparse_indices == nullptr || view.sparse_values == nullptr) {
+      return std::nullopt;
+    }
+  }
+  return view;
+}
+
+void decode_accessor(const GltfAccessorView &view, std::size_t first,
+                     std::size_t last, float *out, int out_components) {
+  assert(first <= last && last <= view.count);
+  const ComponentFormat &format = *find_format(view.component_type);
+  const std::size_t count = last - first;
+  const std::size_t element_size = format.size * view.components;
+  const bool packed = view.stride == element_size &&
+                      view.components == out_components;
+  const std::byte *src =
+      view.data != nullptr ? view.data + first * view.stride : nullptr;
+
+  if (view.data == nullptr) {
+    std::fill_n(out, count * out_components, 0.0f);
+  } else if (packed &&
+             view.component_type == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+    std::memcpy(out, src, count * element_size);
+  } else if (packed &&
+             view.component_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+    const float scale =
+        view.normalized ? 1.0f / std::numeric_limits<uint16_t>::max() : 1.0f;
+    convert_uint16(src, count * out_components, scale, out);
+  } else if (view.component_type == TINYGLTF_COMPONENT_TYPE_FLOAT &&
+             view.components >= out_components) {
+    // interleaved floats, a copy per element
+    for (std::size_t i = 0; i < count; ++i) {
+      std::memcpy(out + i * out_components, src + i * view.stride,
+                  out_components * sizeof(float));
+    }
+  } else {
+    format.decode(src, view.stride, count, view.components, view.normalized,
+                  out, out_components);
+  }
+
+  for_each_sparse(view, first, last, element_size,
+                  [&](std::size_t element, const std::byte *value) {
+                    format.decode(value, element_size, 1, view.components,
+                                  view.normalized,
+                                  out + (element - first) * out_components,
+                                  out_components);
+                  });
+}
+
+bool decode_indices(const GltfAccessorView &view, std::span<uint32_t> out) {
+  const ComponentFormat &format = *find_format(view.component_type);
+  if (format.index == nullptr || view.components != 1) {
+    return false;
+  }
+  assert(out.size() <= view.count);
+  const bool packed = view.stride == format.size;
+
+  if (view.data == nullptr) {
+    std::ranges::fill(out, 0U);
+  } else if (packed &&
+             view.component_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+    widen_uint16(view.data, out.size(), out.data());
+  } else if (packed &&
+             view.component_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
+    std::memcpy(out.data(), view.data, out.size_bytes());
+  } else {
+    for (std::size_t i = 0; i < out.size(); ++i) {
+      out[i] = format.index(view.data + i * view.stride);
+    }
+  }
+
+  for_each_sparse(view, 0, out.size(), format.size,
+                  [&](std::size_t element, const std::byte *value) {
+                    out[element] = format.index(value);
+                  });
+  return true;
+}
+}  // namespace ice
@@ -0,0 +1,55 @@
+#ifndef GLTF_ACCESSOR_HPP
+#define GLTF_ACCESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <tiny_gltf.h>
+
+namespace ice {
+
+/**
+ * A glTF accessor resolved against its buffer view and buffer, validated
+ * once so ranges of it can be decoded from several threads. Elements are
+ * stride bytes apart (interleaved views), a null data pointer means every
+ * element starts out as zeros. Sparse accessors substitute sparse_count
+ * elements, their indices are ascending as the spec requires.
+ */
+struct GltfAccessorView {
+  const std::byte *data{nullptr};
+  std::size_t stride{0};
+  std::size_t count{0};
+  int component_type{0};
+  int components{0};
+  bool normalized{false};
+
+  const std::byte *sparse_indices{nullptr};
+  int sparse_index_type{0};
+  const std::byte *sparse_values{nullptr};
+  std::size_t sparse_count{0};
+};
+
+// nullopt for unknown component types and for elements or sparse data
+// outside of their buffers
+std::optional<GltfAccessorView> view_accessor(
+    const tinygltf::Model &model, const tinygltf::Accessor &accessor);
+
+/**
+ * Decodes elements [first, last) of view as floats, out_components per
+ * element into out ((last - first) * out_components floats). Normalized
+ * integers map to [0, 1] or [-1, 1], the others convert by value. Extra
+ * source components are dropped (COLOR_0 alpha), missing ones are 0.
+ * Tightly packed float and uint16 data takes vectorized paths, everything
+ * else goes through the component table.
+ */
+void decode_accessor(const GltfAccessorView &view, std::size_t first,
+                     std::size_t last, float *out, int out_components);
+
+// Decodes an index accessor (unsigned byte, short or int), false for other
+// component types
+bool decode_indices(const GltfAccessorView &view, std::span<uint32_t> out);
+}  // namespace ice
+
+#endif  // GLTF_ACCESSOR_HPP
@@ -0,0 +1,446 @@
+#include "ice_baked_texture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+namespace ice_image {
+
+namespace {
+constexpr std::array<unsigned char, 12> IDENTIFIER = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+// marks the files baked by us, the value stamps their source
+constexpr std::string_view SOURCE_KEY = "ice.source";
+constexpr std::string_view WRITER_KEY = "KTXwriter";
+constexpr std::string_view WRITER = "ice texture baker";
+
+// KTX2 header and index, little endian like the host
+struct Header {
+  std::array<unsigned char, 12> identifier;
+  uint32_t vk_format;
+  uint32_t type_size;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t layer_count;
+  uint32_t face_count;
+  uint32_t level_count;
+  uint32_t supercompression_scheme;
+  uint32_t dfd_byte_offset;
+  uint32_t dfd_byte_length;
+  uint32_t kvd_byte_offset;
+  uint32_t kvd_byte_length;
+  uint64_t sgd_byte_offset;
+  uint64_t sgd_byte_length;
+};
+static_assert(sizeof(Header) == 80);
+
+// followed by level_count of these, the full size level first
+struct LevelEntry {
+  uint64_t byte_offset;
+  uint64_t byte_length;
+  uint64_t uncompressed_byte_length;
+};
+
+// the formats textures can be sampled from, by block
+struct FormatInfo {
+  vk::Format format;
+  uint32_t block_extent;
+  uint32_t block_bytes;
+};
+
+constexpr std::array<FormatInfo, 12> FORMATS = {{
+    {vk::Format::eR8G8B8A8Srgb, 1, 4},
+    {vk::Format::eR8G8B8A8Unorm, 1, 4},
+    {vk::Format::eBc1RgbSrgbBlock, 4, 8},
+    {vk::Format::eBc1RgbUnormBlock, 4, 8},
+    {vk::Format::eBc1RgbaSrgbBlock, 4, 8},
+    {vk::Format::eBc1RgbaUnormBlock, 4, 8},
+    {vk::Format::eBc2SrgbBlock, 4, 16},
+    {vk::Format::eBc2UnormBlock, 4, 16},
+    {vk::Format::eBc3SrgbBlock, 4, 16},
+    {vk::Format::eBc3UnormBlock, 4, 16},
+    {vk::Format::eBc7SrgbBlock, 4, 16},
+    {vk::Format::eBc7UnormBlock, 4, 16},
+}};
+
+const FormatInfo *find_format(uint32_t vk_format) {
+  const auto *format = std::find_if(
+      FORMATS.begin(), FORMATS.end(), [vk_format](const FormatInfo &info) {
+        return static_cast<uint32_t>(info.format) == vk_format;
+      });
+  return format != FORMATS.end() ? format : nullptr;
+}
+
+uint64_t level_size(const FormatInfo &format, uint32_t width,
+                    uint32_t height) {
+  const uint64_t columns =
+      (uint64_t{width} + format.block_extent - 1) / format.block_extent;
+  const uint64_t rows =
+      (uint64_t{height} + format.block_extent - 1) / format.block_extent;
+  return columns * rows * format.block_bytes;
+}
+
+// size and modification time of source, nullopt if it is missing
+std::optional<std::string> source_stamp(const std::string &source) {
+  std::error_code error;
+  const uint64_t size = std::filesystem::file_size(source, error);
+  if (error) {
+    return std::nullopt;
+  }
+  const int64_t modified = std::filesystem::last_write_time(source, error)
+                               .time_since_epoch()
+                               .count();
+  if (error) {
+    return std::nullopt;
+  }
+  return std::format("{} {}", size, modified);
+}
+
+// the SOURCE_KEY value of the key/value data matches source
+bool baked_from(std::string_view file, const Header &header,
+                const std::string &source) {
+  const uint64_t kvd_end =
+      uint64_t{header.kvd_byte_offset} + header.kvd_byte_length;
+  const std::optional<std::string> stamp = source_stamp(source);
+  if (!stamp || kvd_end > file.size()) {
+    return false;
+  }
+  std::string_view kvd =
+      file.substr(header.kvd_byte_offset, header.kvd_byte_length);
+  while (kvd.size() >= sizeof(uint32_t)) {
+    uint32_t length = 0;
+    std::memcpy(&length, kvd.data(), sizeof(length));
+    kvd.remove_prefix(sizeof(length));
+    if (length > kvd.size()) {
+      return false;
+    }
+    const std::string_view entry = kvd.substr(0, length);
+    const std::size_t key_end = entry.find('\0');
+    if (key_end != std::string_view::npos &&
+        entry.substr(0, key_end) == SOURCE_KEY) {
+      std::string_view value = entry.substr(key_end + 1);
+      if (!value.empty() && value.back() == '\0') {
+        value.remove_suffix(1);
+      }
+      return value == *stamp;
+    }
+    // entries are padded to 4 bytes
+    kvd.remove_prefix(std::min<std::size_t>((length + 3) & ~3U, kvd.size()));
+  }
+  return false;
+}
+
+// KHR data format descriptor of RGBA8: a basic block with four 8 bit samples
+std::array<uint32_t, 23> make_rgba8_dfd(bool srgb) {
+  constexpr uint32_t SAMPLE_COUNT = 4;
+  constexpr uint32_t BLOCK_SIZE = 24 + 16 * SAMPLE_COUNT;
+  constexpr uint32_t MODEL_RGBSDA = 1;
+  constexpr uint32_t PRIMARIES_BT709 = 1;
+  constexpr uint32_t TRANSFER_LINEAR = 1;
+  constexpr uint32_t TRANSFER_SRGB = 2;
+  constexpr uint32_t CHANNEL_ALPHA = 15;
+  constexpr uint32_t QUALIFIER_LINEAR = 0x10;
+
+  std::array<uint32_t, 23> dfd{};
+  dfd[0] = sizeof(dfd);  // total size
+  dfd[1] = 0;            // Khronos vendor, basic format descriptor
+  dfd[2] = 2 | (BLOCK_SIZE << 16);  // version 1.3
+  dfd[3] = MODEL_RGBSDA | (PRIMARIES_BT709 << 8) |
+           ((srgb ? TRANSFER_SRGB : TRANSFER_LINEAR) << 16);
+  dfd[4] = 0;  // 1 x 1 texel blocks
+  dfd[5] = 4;  // bytes in plane 0
+  for (uint32_t sample = 0; sample < SAMPLE_COUNT; ++sample) {
+    // alpha is never sRGB encoded
+    const uint32_t channel =
+        sample < 3 ? sample : CHANNEL_ALPHA | (srgb ? QUALIFIER_LINEAR : 0);
+    uint32_t *words = &dfd[7 + sample * 4];
+    words[0] = (sample * 8) | (7 << 16) | (channel << 24);
+    words[1] = 0;    // sample position
+    words[2] = 0;    // lower
+    words[3] = 255;  // upper
+  }
+  return dfd;
+}
+
+void append_key_value(std::vector<char> &kvd, std::string_view key,
+                      std::string_view value) {
+  const auto length = static_cast<uint32_t>(key.size() + value.size() + 2);
+  const auto *length_bytes = reinterpret_cast<const char *>(&length);
+  kvd.insert(kvd.end(), length_bytes, length_bytes + sizeof(length));
+  kvd.insert(kvd.end(), key.begin(), key.end());
+  kvd.push_back('\0');
+  kvd.insert(kvd.end(), value.begin(), value.end());
+  kvd.push_back('\0');
+  kvd.resize((kvd.size() + 3) & ~std::size_t{3});
+}
+
+// linear value of every sRGB code
+const std::array<float, 256> &srgb_to_linear() {
+  static const std::array<float, 256> table = [] {
+    std::array<float, 256> values{};
+    for (std::size_t code = 0; code < values.size(); ++code) {
+      const double srgb = static_cast<double>(code) / 255.0;
+      values[code] = static_cast<float>(
+          srgb <= 0.04045 ? srgb / 12.92
+                          : std::pow((srgb + 0.055) / 1.055, 2.4));
+    }
+    return values;
+  }();
+  return table;
+}
+
+// linear values halfway (in sRGB) between two codes, rounding back to sRGB
+// is a search through them
+const std::array<float, 255> &srgb_thresholds() {
+  static const std::array<float, 255> table = [] {
+    std::array<float, 255> values{};
+    for (std::size_t code = 0; code < values.size(); ++code) {
+      const double srgb = (static_cast<double>(code) + 0.5) / 255.0;
+      values[code] = static_cast<float>(
+          srgb <= 0.04045 ? srgb / 12.92
+                          : std::pow((srgb + 0.055) / 1.055, 2.4));
+    }
+    return values;
+  }();
+  return table;
+}
+
+unsigned char linear_to_srgb(float linear) {
+  const std::array<float, 255> &thresholds = srgb_thresholds();
+  return static_cast<unsigned char>(
+      std::upper_bound(thresholds.begin(), thresholds.end(), linear) -
+      thresholds.begin());
+}
+
+// one 2 x 2 box filtered level below src
+std::vector<unsigned char> downsample(const unsigned char *src,
+                                      uint32_t src_width, uint32_t src_height,
+                                      uint32_t width, uint32_t height) {
+  const std::array<float, 256> &linear = srgb_to_linear();
+  std::vector<unsigned char> level(std::size_t{width} * height * 4);
+  for (uint32_t y = 0; y < height; ++y) {
+    const std::array<uint32_t, 2> rows = {std::min(2 * y, src_height - 1),
+                                          std::min(2 * y + 1, src_height - 1)};
+    for (uint32_t x = 0; x < width; ++x) {
+      const std::array<uint32_t, 2> columns = {
+          std::min(2 * x, src_width - 1), std::min(2 * x + 1, src_width - 1)};
+      std::array<float, 3> color{};
+      uint32_t alpha = 2;  // rounds
+      for (const uint32_t row : rows) {
+        for (const uint32_t column : columns) {
+          const unsigned char *texel =
+              src + (std::size_t{row} * src_width + column) * 4;
+          for (std::size_t channel = 0; channel < 3; ++channel) {
+            color[channel] += linear[texel[channel]];
+          }
+          alpha += texel[3];
+        }
+      }
+      unsigned char *out = level.data() + (std::size_t{y} * width + x) * 4;
+      for (std::size_t channel = 0; channel < 3; ++channel) {
+        out[channel] = linear_to_srgb(color[channel] * 0.25f);
+      }
+      out[3] = static_cast<unsigned char>(alpha / 4);
+    }
+  }
+  return level;
+}
+}  // namespace
+
+bool runtime_baking() {
+  static const bool enabled = [] {
+    const char *setting = std::getenv("ICE_BAKE_TEXTURES");
+    return setting != nullptr && std::string_view(setting) == "1";
+  }();
+  return enabled;
+}
+
+std::string baked_texture_path(const std::string &source) {
+  return source + ".ktx2";
+}
+
+std::optional<std::string> find_baked_texture(const std::string &source) {
+  if (source.ends_with(".ktx2")) {
+    return source;
+  }
+  std::string path = baked_texture_path(source);
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(path, error)) {
+    return std::nullopt;
+  }
+  return path;
+}
+
+std::uint32_t mip_level_count(std::uint32_t width, std::uint32_t height) {
+  return std::max<std::uint32_t>(std::bit_width(std::max(width, height)), 1);
+}
+
+std::optional<BakedTexture> read_ktx2(std::string_view file,
+                                      const std::string *source) {
+  if (file.size() < sizeof(Header)) {
+    return std::nullopt;
+  }
+
+  Header header{};
+  std::memcpy(&header, file.data(), sizeof(header));
+  const FormatInfo *format = find_format(header.vk_format);
+  // only plain 2D textures, with their levels present
+  if (header.identifier != IDENTIFIER || format == nullptr ||
+      header.pixel_width == 0 || header.pixel_height == 0 ||
+      header.pixel_depth != 0 || header.layer_count > 1 ||
+      header.face_count != 1 || header.level_count == 0 ||
+      header.level_count >
+          mip_level_count(header.pixel_width, header.pixel_height) ||
+      header.supercompression_scheme != 0 ||
+      header.level_count >
+          (file.size() - sizeof(Header)) / sizeof(LevelEntry)) {
+    return std::nullopt;
+  }
+  if (source != nullptr && !baked_from(file, header, *source)) {
+    return std::nullopt;
+  }
+
+  BakedTexture texture{.format = format->format};
+  texture.levels.resize(header.level_count);
+  for (uint32_t level = 0; level < header.level_count; ++level) {
+    LevelEntry entry{};
+    std::memcpy(&entry,
+                file.data() + sizeof(Header) + level * sizeof(LevelEntry),
+                sizeof(entry));
+    const uint32_t width = std::max(header.pixel_width >> level, 1U);
+    const uint32_t height = std::max(header.pixel_height >> level, 1U);
+    const uint64_t size = level_size(*format, width, height);
+    // rejects truncated files
+    if (entry.byte_offset > file.size() || entry.byte_length < size ||
+        size > file.size() - entry.byte_offset) {
+      return std::nullopt;
+    }
+    texture.levels[level] = {
+        .width = width,
+        .height = height,
+        .data = {reinterpret_cast<const unsigned char *>(file.data()) +
+                     entry.byte_offset,
+                 static_cast<std::size_t>(size)}};
+  }
+  return texture;
+}
+
+bool write_baked_texture(const std::string &source,
+                         const BakedTexture &texture) {
+  const std::optional<std::string> stamp = source_stamp(source);
+  const bool srgb = texture.format == vk::Format::eR8G8B8A8Srgb;
+  if (!stamp || texture.levels.empty() ||
+      (!srgb && texture.format != vk::Format::eR8G8B8A8Unorm)) {
+    return false;
+  }
+
+  const std::array<uint32_t, 23> dfd = make_rgba8_dfd(srgb);
+  // keys are sorted
+  std::vector<char> kvd;
+  append_key_value(kvd, WRITER_KEY, WRITER);
+  append_key_value(kvd, SOURCE_KEY, *stamp);
+
+  const auto level_count = static_cast<uint32_t>(texture.levels.size());
+  const auto dfd_offset =
+      static_cast<uint32_t>(sizeof(Header) + level_count * sizeof(LevelEntry));
+  const Header header{
+      .identifier = IDENTIFIER,
+      .vk_format = static_cast<uint32_t>(texture.format),
+      .type_size = 1,
+      .pixel_width = texture.levels[0].width,
+      .pixel_height = texture.levels[0].height,
+      .pixel_depth = 0,
+      .layer_count = 0,
+      .face_count = 1,
+      .level_count = level_count,
+      .supercompression_scheme = 0,
+      .dfd_byte_offset = dfd_offset,
+      .dfd_byte_length = sizeof(dfd),
+      .kvd_byte_offset = static_cast<uint32_t>(dfd_offset + sizeof(dfd)),
+      .kvd_byte_length = static_cast<uint32_t>(kvd.size()),
+      .sgd_byte_offset = 0,
+      .sgd_byte_length = 0};
+
+  // the levels follow the key/value data (4 byte aligned, as RGBA8 levels
+  // need), the smallest first
+  std::vector<LevelEntry> entries(level_count);
+  uint64_t offset = uint64_t{header.kvd_byte_offset} + header.kvd_byte_length;
+  for (uint32_t level = level_count; level-- > 0;) {
+    const uint64_t size = texture.levels[level].data.size();
+    entries[level] = {
+        .byte_offset = offset, .byte_length = size,
+        .uncompressed_byte_length = size};
+    offset += size;
+  }
+
+  // written aside and renamed, so a crash never leaves a torn bake behind
+  const std::string path = baked_texture_path(source);
+  const std::string temporary_path = path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(entries.data()),
+               static_cast<std::streamsize>(entries.size() *
+                                            sizeof(LevelEntry)));
+    file.write(reinterpret_cast<const char *>(dfd.data()), sizeof(dfd));
+    file.write(kvd.data(), static_cast<std::streamsize>(kvd.size()));
+    for (uint32_t level = level_count; level-- > 0;) {
+      const std::span<const unsigned char> data = texture.levels[level].data;
+      file.write(reinterpret_cast<const char *>(data.data()),
+                 static_cast<std::streamsize>(data.size()));
+    }
+    if (!file) {
+      file.close();
+      std::error_code error;
+      std::filesystem::remove(temporary_path, error);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, path, error);
+  return !error;
+}
+
+std::vector<std::vector<unsigned char>> make_mip_chain(
+    const unsigned char *rgba, std::uint32_t width, std::uint32_t height) {
+  std::vector<std::vector<unsigned char>> levels;
+  const std::uint32_t level_count = mip_level_count(width, height);
+  levels.reserve(level_count - 1);
+  const unsigned char *src = rgba;
+  for (std::uint32_t level = 1; level < level_count; ++level) {
+    const std::uint32_t level_width = std::max(width >> level, 1U);
+    const std::uint32_t level_height = std::max(height >> level, 1U);
+    levels.push_back(downsample(src, std::max(width >> (level - 1), 1U),
+                                std::max(height >> (level - 1), 1U),
+                                level_width, level_height));
+    src = levels.back().data();
+  }
+  return levels;
+}
+
+BakedTexture make_baked_texture(const unsigned char *rgba, std::uint32_t width,
+                                std::uint32_t height,
+                                std::vector<std::vector<unsigned char>> &mips) {
+  mips = make_mip_chain(rgba, width, height);
+
+  BakedTexture baked{.format = vk::Format::eR8G8B8A8Srgb};
+  baked.levels.push_back(
+      {.width = width,
+       .height = height,
+       .data = {rgba, static_cast<std::size_t>(width) * height * 4}});
+  for (std::uint32_t level = 1; level <= mips.size(); ++level) {
+    baked.levels.push_back({.width = std::max(width >> level, 1U),
+                            .height = std::max(height >> level, 1U),
+                            .data = mips[level - 1]});
+  }
+  return baked;
+}
+}  // namespace ice_image
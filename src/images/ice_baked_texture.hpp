@@ -0,0 +1,77 @@
+#ifndef ICE_BAKED_TEXTURE_HPP
+#define ICE_BAKED_TEXTURE_HPP
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../config.hpp"
+
+namespace ice_image {
+
+/**
+ * Textures stored with their whole mip chain in a KTX2 container (2D, one
+ * layer and face, no supercompression), so they are copied to the GPU as
+ * they are instead of having their mips generated on every start. An image
+ * file is baked next to itself (<file>.ktx2) by tools/ice_bake, or the first
+ * time it is loaded if runtime_baking() is on, and the bake only matches
+ * while the file keeps the size and modification time it was baked from.
+ * .ktx2 files made by other tools, e.g. with BCn compressed levels, can be
+ * loaded directly.
+ */
+struct BakedLevel {
+  std::uint32_t width{}, height{};
+  std::span<const unsigned char> data;
+};
+
+struct BakedTexture {
+  vk::Format format{vk::Format::eR8G8B8A8Srgb};
+  std::vector<BakedLevel> levels;  // the full size image first
+};
+
+// Whether loading an image file without an up to date bake also bakes it
+// (ICE_BAKE_TEXTURES=1). Off by default: baking builds the mip chain on the
+// CPU and writes into the resources tree, which may be read-only, while
+// without it the mips are generated on the GPU at upload.
+bool runtime_baking();
+
+// Where the bake of the image file source lives
+std::string baked_texture_path(const std::string &source);
+
+// The .ktx2 file to read for source: source itself if it is one, else its
+// bake if that exists (only checked, not read).
+std::optional<std::string> find_baked_texture(const std::string &source);
+
+// Levels of a width x height image, down to 1 x 1
+std::uint32_t mip_level_count(std::uint32_t width, std::uint32_t height);
+
+// The texture in file, a mapped .ktx2 file, its levels point into the
+// mapping. Empty if the file is malformed or of an unsupported kind, or, if
+// source is given, was not baked from source as it is now.
+std::optional<BakedTexture> read_ktx2(std::string_view file,
+                                      const std::string *source = nullptr);
+
+// Writes the bake of source (RGBA8 levels), replacing the old one only once
+// complete. Returns false if source is missing or the file could not be
+// written.
+bool write_baked_texture(const std::string &source,
+                         const BakedTexture &texture);
+
+/**
+ * Levels 1 and below of the width x height RGBA8 sRGB image rgba, each a
+ * 2 x 2 box filter of the one above (in linear space, as blits of sRGB
+ * images filter).
+ */
+std::vector<std::vector<unsigned char>> make_mip_chain(
+    const unsigned char *rgba, std::uint32_t width, std::uint32_t height);
+
+// The full mip chain of the width x height RGBA8 sRGB image rgba, as baked.
+// Its levels point into rgba and into mips, which make_mip_chain fills.
+BakedTexture make_baked_texture(const unsigned char *rgba, std::uint32_t width,
+                                std::uint32_t height,
+                                std::vector<std::vector<unsigned char>> &mips);
+}  // namespace ice_image
+
+#endif  // ICE_BAKED_TEXTURE_HPP
@@ -3,10 +3,13 @@
 
 #include "../data_buffers.hpp"
 #include "../descriptors.hpp"
+#include "../multithreading/ice_parallel.hpp"
 
 namespace ice_image {
 
-CubeMap::CubeMap(const TextureCreationInput &input) {
+CubeMap::CubeMap(const TextureCreationInput &input,
+                 ice_threading::Scheduler *scheduler)
+    : scheduler(scheduler) {
   logical_device = input.logical_device;
   physical_device = input.physical_device;
   filenames = input.filenames;
@@ -14,6 +17,13 @@ CubeMap::CubeMap(const TextureCreationInput &input) {
   queue = input.queue;
   layout = input.layout;
   descriptor_pool = input.descriptor_pool;
+  staging_allocator = input.staging;
+  if (staging_allocator == nullptr) {
+    own_staging = std::make_unique<ice::StagingAllocator>(
+        ice::StagingAllocatorInput{.physical_device = physical_device,
+                                   .logical_device = logical_device});
+    staging_allocator = own_staging.get();
+  }
 
   // Ensure files are FACES_IN_CUBE in number
   const int number_of_files = static_cast<int>(filenames.size());
@@ -55,9 +65,9 @@ CubeMap::CubeMap(const TextureCreationInput &input) {
 
   populate();
 
-  for (auto &pixel : pixels) {
-    stbi_image_free(pixel);
-  }
+  // the copy completed, the staging memory goes back to the allocator
+  staged.reset();
+  own_staging.reset();
 
   make_view();
 
@@ -81,53 +91,50 @@ void CubeMap::load() {
 #ifndef NDEBUG
   std::cout << "\nLoading CubeMaps.....\n";
 #endif
-  for (int i = 0; i < FACES_IN_CUBE; i++) {
-    pixels[i] = stbi_load(filenames[i].c_str(), &width, &height, &channels,
-                          STBI_rgb_alpha);
-    if (pixels[i] == nullptr) {
-      // Error Recovery
-      std::cout << std::format("Unable to load: {}", filenames[i]) << std::endl;
-      width = height = 10;
-      channels = 4;
+  // the first face sizes the cube, its header is enough to stage all of them
+  int components = 0;
+  if (stbi_info(filenames[0].c_str(), &width, &height, &components) == 0) {
+    width = height = 10;
+  }
+  channels = 4;
+  const std::size_t face_size = static_cast<std::size_t>(width * height) * 4;
+  staged = staging_allocator->allocate(face_size * FACES_IN_CUBE);
+
+  // a face per job, file reads included
+  ice_threading::parallel_for(
+      scheduler, 0, FACES_IN_CUBE, 1,
+      [this, face_size](std::size_t first, std::size_t last) {
+        for (std::size_t face = first; face < last; ++face) {
+          load_face(static_cast<int>(face), staged.data() + face_size * face);
+        }
+      });
+}
+
+void CubeMap::load_face(int face, std::byte *face_location) const {
+  const std::size_t face_size = static_cast<std::size_t>(width * height) * 4;
+  int face_width = 0;
+  int face_height = 0;
+  int face_channels = 0;
+  stbi_uc *pixels = stbi_load(filenames[face].c_str(), &face_width,
+                              &face_height, &face_channels, STBI_rgb_alpha);
+  if (pixels != nullptr && face_width == width && face_height == height) {
+    memcpy(face_location, pixels, face_size);
+  } else {
+    // Error Recovery
+    std::cout << std::format("Unable to load: {}", filenames[face])
+              << std::endl;
 #ifndef NDEBUG
-      std::cout << std::format(
-          "Empty load in image {},  Allocated random image of size {} x {}\n",
-          i, width, height);
+    std::cout << std::format(
+        "Empty load in image {},  Allocated random image of size {} x {}\n",
+        face, width, height);
 #endif
-      pixels[i] =
-          new stbi_uc[static_cast<std::size_t>(width * height * channels)];
-      memset(pixels[i], 255,
-             static_cast<std::size_t>(width * height) * channels);
-    }
+    memset(face_location, 255, face_size);
   }
+  stbi_image_free(pixels);
 }
 
 void CubeMap::populate() {
-  const std::uint32_t image_size = width * height * 4;
-  // First create a CPU-visible buffer...
-  const ice::BufferCreationInput input{
-      .size = static_cast<std::size_t>(image_size) * FACES_IN_CUBE,
-      .usage = vk::BufferUsageFlagBits::eTransferSrc,
-
-      .memory_properties = vk::MemoryPropertyFlagBits::eHostCoherent |
-                           vk::MemoryPropertyFlagBits::eHostVisible,
-
-      .logical_device = logical_device,
-      .physical_device = physical_device,
-  };
-
-  const ice::BufferBundle staging_buffer = create_buffer(input);
-
-  // fill all of them
-  for (int i = 0; i < FACES_IN_CUBE; ++i) {
-    void *write_location = logical_device.mapMemory(
-        staging_buffer.buffer_memory,
-        static_cast<vk::DeviceSize>(image_size) * i, image_size);
-    memcpy(write_location, pixels[i], image_size);
-    logical_device.unmapMemory(staging_buffer.buffer_memory);
-  }
-
-  // then transfer it to image memory
+  // the faces are already in the staging buffer, transfer it to image memory
   ImageLayoutTransitionJob transition_job{
       .command_buffer = command_buffer,
       .queue = queue,
@@ -140,7 +147,7 @@ void CubeMap::populate() {
 
   const BufferImageCopyJob copy_job{.command_buffer = command_buffer,
                                     .queue = queue,
-                                    .src_buffer = staging_buffer.buffer,
+                                    .src_buffer = staged.buffer(),
                                     .dst_image = image,
                                     .width = width,
                                     .height = height,
@@ -151,10 +158,6 @@ void CubeMap::populate() {
   transition_job.old_layout = vk::ImageLayout::eTransferDstOptimal;
   transition_job.new_layout = vk::ImageLayout::eShaderReadOnlyOptimal;
   transition_image_layout(transition_job);
-
-  // Now the staging buffer can be destroyed
-  logical_device.freeMemory(staging_buffer.buffer_memory);
-  logical_device.destroyBuffer(staging_buffer.buffer);
 }
 
 void CubeMap::make_view() {
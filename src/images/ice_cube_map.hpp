@@ -2,15 +2,22 @@
 #define ICE_CUBE_MAP_HPP
 
 #include "../config.hpp"
+#include "../staging_allocator.hpp"
 #include "ice_image.hpp"
 
+namespace ice_threading {
+class Scheduler;
+}
+
 namespace ice_image {
 
 inline const constexpr int FACES_IN_CUBE = 6;
 
 class CubeMap {
  public:
-  explicit CubeMap(const TextureCreationInput &input);
+  // The faces are decoded in parallel on scheduler, if given.
+  explicit CubeMap(const TextureCreationInput &input,
+                   ice_threading::Scheduler *scheduler = nullptr);
 
   void use(vk::CommandBuffer recording_command_buffer,
            vk::PipelineLayout pipeline_layout);
@@ -22,7 +29,11 @@ class CubeMap {
   vk::Device logical_device;
   vk::PhysicalDevice physical_device;
   std::vector<std::string> filenames;
-  stbi_uc *pixels[FACES_IN_CUBE] = {};  // NOLINT (modernize-avoid-c-arrays)
+  ice_threading::Scheduler *scheduler{};
+  ice::StagingAllocator *staging_allocator{};
+  std::unique_ptr<ice::StagingAllocator> own_staging;  // if none was given
+  // the faces, one after the other, until populate() copied them
+  ice::StagingAllocator::Allocation staged;
 
   // Resources
   vk::Image image;
@@ -38,10 +49,13 @@ class CubeMap {
   vk::CommandBuffer command_buffer;
   vk::Queue queue;
 
-  // Load the raw image data from the internally set filepath.
-  // Errors will be handled externally
+  // Decode the faces from the internally set filepaths into staging memory.
+  // A face that can not be loaded is white.
   void load();
 
+  // Decode one face into its slice of the staging memory.
+  void load_face(int face, std::byte *face_location) const;
+
   /**
    * Send loaded data to the image. The image must be loaded before calling
    * this function.
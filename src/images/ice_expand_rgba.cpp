@@ -0,0 +1,92 @@
+#include "ice_expand_rgba.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#define ICE_IMAGE_AVX2
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#define ICE_IMAGE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace ice_image {
+namespace {
+// RGB to RGBA, the last pixel is handled apart since every pixel is read
+// as 4 bytes
+void expand_rgb(const unsigned char *src, std::size_t pixel_count,
+                unsigned char *dst) {
+  std::size_t i = 0;
+#if defined(ICE_IMAGE_AVX2) || defined(ICE_IMAGE_SSSE3)
+  // 4 pixels per 128 bit lane, the shuffle leaves alpha zero
+  const __m128i rgb_to_rgba =
+      _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+#endif
+#if defined(ICE_IMAGE_AVX2)
+  const __m256i shuffle = _mm256_broadcastsi128_si256(rgb_to_rgba);
+  const __m256i alpha_256 = _mm256_broadcastsi128_si256(alpha);
+  // the second lane reads 16 bytes from pixel i + 4
+  for (; i + 10 <= pixel_count; i += 8) {
+    const __m256i rgb = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3 + 12)),
+        1);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(dst + i * 4),
+        _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha_256));
+  }
+#endif
+#if defined(ICE_IMAGE_AVX2) || defined(ICE_IMAGE_SSSE3)
+  for (; i + 6 <= pixel_count; i += 4) {
+    const __m128i rgb =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4),
+                     _mm_or_si128(_mm_shuffle_epi8(rgb, rgb_to_rgba), alpha));
+  }
+#endif
+  for (; i + 1 < pixel_count; ++i) {
+    std::uint32_t pixel;
+    std::memcpy(&pixel, src + i * 3, sizeof(pixel));
+    if constexpr (std::endian::native == std::endian::little) {
+      pixel |= 0xFF000000U;
+    } else {
+      pixel |= 0xFFU;
+    }
+    std::memcpy(dst + i * 4, &pixel, sizeof(pixel));
+  }
+  for (; i < pixel_count; ++i) {
+    const unsigned char pixel[4] = {src[i * 3], src[i * 3 + 1],
+                                    src[i * 3 + 2], 255};
+    std::memcpy(dst + i * 4, pixel, sizeof(pixel));
+  }
+}
+}  // namespace
+
+void expand_to_rgba(const unsigned char *src, int components,
+                    std::size_t pixel_count, unsigned char *dst) {
+  switch (components) {
+    case 4:
+      std::memcpy(dst, src, pixel_count * 4);
+      break;
+    case 3:
+      expand_rgb(src, pixel_count, dst);
+      break;
+    default:
+      // grey (and alpha)
+      for (std::size_t i = 0; i < pixel_count; ++i) {
+        const unsigned char grey = src[i * components];
+        const unsigned char pixel[4] = {
+            grey, grey, grey,
+            components == 2 ? src[i * components + 1]
+                            : static_cast<unsigned char>(255)};
+        std::memcpy(dst + i * 4, pixel, sizeof(pixel));
+      }
+      break;
+  }
+}
+
+}  // namespace ice_image
@@ -0,0 +1,18 @@
+#ifndef ICE_EXPAND_RGBA_HPP
+#define ICE_EXPAND_RGBA_HPP
+
+#include <cstddef>
+
+namespace ice_image {
+
+/**
+ * Expand pixel_count 8 bit pixels of 1 to 4 components to RGBA: grey is
+ * replicated to RGB, missing alpha is opaque. dst may be mapped (write
+ * combined) memory, it is written sequentially and never read. RGB is
+ * expanded with SSSE3 or AVX2 shuffles where the build targets them.
+ */
+void expand_to_rgba(const unsigned char *src, int components,
+                    std::size_t pixel_count, unsigned char *dst);
+}  // namespace ice_image
+
+#endif  // ICE_EXPAND_RGBA_HPP
@@ -137,6 +137,45 @@ void copy_buffer_to_image(const BufferImageCopyJob &copy_job) {
   ice::end_job(copy_job.command_buffer, copy_job.queue);
 }
 
+void copy_mip_levels_to_image(const MipLevelsCopyJob &copy_job) {
+  ice::start_job(copy_job.command_buffer);
+
+  vk::ImageMemoryBarrier barrier{
+      .srcAccessMask = vk::AccessFlagBits::eNoneKHR,
+      .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+      .oldLayout = vk::ImageLayout::eUndefined,
+      .newLayout = vk::ImageLayout::eTransferDstOptimal,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = copy_job.dst_image,
+      .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                           .baseMipLevel = 0,
+                           .levelCount = copy_job.mip_levels,
+                           .baseArrayLayer = 0,
+                           .layerCount = 1}};
+  copy_job.command_buffer.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTopOfPipe,
+      vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr,
+      nullptr, barrier);
+
+  copy_job.command_buffer.copyBufferToImage(
+      copy_job.src_buffer, copy_job.dst_image,
+      vk::ImageLayout::eTransferDstOptimal,
+      static_cast<std::uint32_t>(copy_job.regions.size()),
+      copy_job.regions.data());
+
+  barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+  barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  copy_job.command_buffer.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer,
+      vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(),
+      nullptr, nullptr, barrier);
+
+  ice::end_job(copy_job.command_buffer, copy_job.queue);
+}
+
 vk::ImageView make_image_view(vk::Device logical_device, vk::Image image,
                               vk::Format format, vk::ImageAspectFlags aspect,
                               vk::ImageViewType view_type,
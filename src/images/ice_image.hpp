@@ -3,7 +3,14 @@
 
 #include <stb_image.h>
 
+#include <span>
+
 #include "../config.hpp"
+#include "ice_expand_rgba.hpp"
+
+namespace ice {
+class StagingAllocator;
+}
 
 namespace ice_image {
 
@@ -16,6 +23,9 @@ struct TextureCreationInput {
   vk::DescriptorSetLayout layout;
   vk::DescriptorPool descriptor_pool;
   std::vector<std::string> filenames;
+  // decoded pixels are staged in its buffers, each texture makes its own
+  // staging buffer if null
+  ice::StagingAllocator *staging{nullptr};
 };
 
 // VkImage creation struct
@@ -53,6 +63,17 @@ struct BufferImageCopyJob {
   std::uint32_t array_count{1};
 };
 
+// input for copying every mip level of an image from a buffer
+struct MipLevelsCopyJob {
+  vk::CommandBuffer command_buffer;
+  vk::Queue queue;
+  vk::Buffer src_buffer;
+  vk::Image dst_image;
+  std::uint32_t mip_levels{1};
+  // one per level: where it is in src_buffer, its level and extent
+  std::span<const vk::BufferImageCopy> regions;
+};
+
 // Make a Vulkan Image
 vk::Image make_image(const ImageCreationInput &input);
 
@@ -77,6 +98,12 @@ void transition_image_layout(ImageLayoutTransitionJob transition_job);
  */
 void copy_buffer_to_image(const BufferImageCopyJob &copy_job);
 
+/**
+ * Copy prebaked mip levels from a buffer to an image in a single
+ * submission, the image goes from undefined to shader_read_only_optimal.
+ */
+void copy_mip_levels_to_image(const MipLevelsCopyJob &copy_job);
+
 // Create a view of a vulkan image.
 vk::ImageView make_image_view(
     vk::Device logical_device, vk::Image image, vk::Format format,
@@ -1,21 +1,34 @@
 #define TINYGLTF_IMPLEMENTATION
+// external images are read by the texture jobs, from their path
+#define TINYGLTF_NO_EXTERNAL_IMAGE
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "ice_texture.hpp"
 
 #include "../data_buffers.hpp"
 #include "../descriptors.hpp"
+#include "../mapped_file.hpp"
 
 namespace ice_image {
 
 Texture::Texture(const TextureCreationInput &input) { load(input, nullptr); }
 
 Texture::Texture(const TextureCreationInput &input,
-                 const std::shared_ptr<tinygltf::Image> &gltf_image) {
+                 const tinygltf::Image *gltf_image) {
   load(input, gltf_image);
 }
 
 void Texture::load(const TextureCreationInput &input,
-                   const std::shared_ptr<tinygltf::Image> &gltf_image) {
+                   const tinygltf::Image *gltf_image) {
+  decode(input, gltf_image);
+  upload(input.command_buffer, input.queue);
+  make_descriptor_set();
+#ifndef NDEBUG
+  std::cout << "Finished Creating the ice_image::Texture Object\n\n"
+            << std::endl;
+#endif
+}
+
+void Texture::bind_input(const TextureCreationInput &input) {
   logical_device = input.logical_device;
   physical_device = input.physical_device;
   filename = !input.filenames.empty() ? input.filenames[0].c_str() : "\0";
@@ -23,43 +36,139 @@ void Texture::load(const TextureCreationInput &input,
   queue = input.queue;
   layout = input.layout;
   descriptor_pool = input.descriptor_pool;
+  staging_allocator = input.staging;
+  if (staging_allocator == nullptr) {
+    own_staging = std::make_unique<ice::StagingAllocator>(
+        ice::StagingAllocatorInput{.physical_device = physical_device,
+                                   .logical_device = logical_device});
+    staging_allocator = own_staging.get();
+  }
+}
 
+void Texture::decode(const TextureCreationInput &input,
+                     const std::vector<unsigned char> &encoded) {
+  bind_input(input);
+
+  pixels = stbi_load_from_memory(encoded.data(),
+                                 static_cast<int>(encoded.size()), &width,
+                                 &height, &channels, STBI_rgb_alpha);
+  if (pixels == nullptr) {
+    use_placeholder();
+    stage();
+  } else if (!input.filenames.empty() && runtime_baking()) {
+    bake(input.filenames[0]);
+  } else {
+    stage();
+  }
+}
+
+bool Texture::decode_baked(const TextureCreationInput &input) {
+  if (input.filenames.empty()) {
+    return false;
+  }
+  const std::optional<std::string> path =
+      find_baked_texture(input.filenames[0]);
+  if (!path) {
+    return false;
+  }
+  const ice::MappedFile file(path->c_str());
+  return decode_baked(input, file.view());
+}
+
+bool Texture::decode_baked(const TextureCreationInput &input,
+                           std::string_view ktx2_file) {
+  if (input.filenames.empty()) {
+    return false;
+  }
+  // a .ktx2 file is loaded as it is, an image file through its bake
+  const std::string &source = input.filenames[0];
+  const bool container = source.ends_with(".ktx2");
+  const std::optional<BakedTexture> baked =
+      read_ktx2(ktx2_file, container ? nullptr : &source);
+  if (!baked) {
+    return false;
+  }
+  // e.g. block compressed formats the device does not support
+  const vk::FormatProperties properties =
+      input.physical_device.getFormatProperties(baked->format);
+  if (!(properties.optimalTilingFeatures &
+        vk::FormatFeatureFlagBits::eSampledImage)) {
+    return false;
+  }
+
+  bind_input(input);
+  width = static_cast<int>(baked->levels[0].width);
+  height = static_cast<int>(baked->levels[0].height);
+  channels = 4;
+  stage_levels(*baked);
+  return true;
+}
+
+void Texture::decode(const TextureCreationInput &input,
+                     const tinygltf::Image *gltf_image) {
   if (gltf_image == nullptr) {
-    // load from file
-    load();
+    // load from file, or its bake
+    if (decode_baked(input)) {
+      return;
+    }
+    bind_input(input);
+    if (load() && runtime_baking()) {
+      bake(input.filenames[0]);
+    } else {
+      stage();
+    }
+  } else if (gltf_image->as_is) {
+    // still encoded, see ice::load_gltf_model
+    decode(input, gltf_image->image);
   } else {
 #ifndef NDEBUG
     std::cout << "\nLoading Embedded Textures .....\n";
 #endif
+    bind_input(input);
     width = gltf_image->width;
     height = gltf_image->height;
-    channels = std::min(4, gltf_image->component);
-    pixels = static_cast<stbi_uc *>(
-        new unsigned char[static_cast<std::size_t>(width * height) * 4]);
-
-    // RGBA format
-    if (channels == 4) {
-      memcpy(pixels, gltf_image->image.data(),
-             static_cast<std::size_t>(width * height) * 4);
-    } else {
-      // Convert to RGBA
-      for (int i = 0; i < width * height; ++i) {
-        for (int j = 0; j < channels; ++j) {
-          pixels[i * 4 + j] = gltf_image->image[i * channels + j];
-        }
-        // Set alpha to 255 if it's not present in the original
-        if (channels < 4) {
-          pixels[i * 4 + 3] = 255;
-        }
-      }
-      channels = 4;
+    channels = 4;
+    const std::size_t pixel_count =
+        static_cast<std::size_t>(std::max(width, 0)) *
+        static_cast<std::size_t>(std::max(height, 0));
+    if (gltf_image->bits != 8 || gltf_image->component < 1 ||
+        gltf_image->component > 4 || pixel_count == 0 ||
+        gltf_image->image.size() < pixel_count * gltf_image->component) {
+      use_placeholder();
+      stage();
+      return;
     }
+    stage(gltf_image->image.data(), gltf_image->component);
+  }
+}
+
+void Texture::stage(const unsigned char *source, int components) {
+  // the mips are generated on upload
+  format = vk::Format::eR8G8B8A8Srgb;
+  staged_levels.clear();
+  const std::size_t pixel_count = static_cast<std::size_t>(width * height);
+  staged = staging_allocator->allocate(pixel_count * 4);
+  if (source != nullptr) {
+    expand_to_rgba(source, components, pixel_count,
+                   reinterpret_cast<unsigned char *>(staged.data()));
+  } else {
+    memcpy(staged.data(), pixels, pixel_count * 4);
+    stbi_image_free(pixels);
+    pixels = nullptr;
   }
+}
+
+void Texture::upload(vk::CommandBuffer upload_command_buffer,
+                     vk::Queue upload_queue) {
+  command_buffer = upload_command_buffer;
+  queue = upload_queue;
 
-  // Calculate mip levels
-  mip_levels = static_cast<std::uint32_t>(
-                   std::floor(std::log2(std::max(width, height)))) +
-               1;  // at least 1
+  // Calculate mip levels, a baked texture brings its own
+  mip_levels = !staged_levels.empty()
+                   ? static_cast<std::uint32_t>(staged_levels.size())
+                   : static_cast<std::uint32_t>(
+                         std::floor(std::log2(std::max(width, height)))) +
+                         1;  // at least 1
 
   const ImageCreationInput image_input{
       .logical_device = logical_device,
@@ -71,8 +180,7 @@ void Texture::load(const TextureCreationInput &input,
                vk::ImageUsageFlagBits::eTransferDst |
                vk::ImageUsageFlagBits::eSampled,
       .memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
-      /* .format = vk::Format::eR8G8B8A8Unorm, */
-      .format = vk::Format::eR8G8B8A8Srgb,
+      .format = format,
       .array_count = 1,
       .mip_levels = mip_levels};
 
@@ -85,21 +193,14 @@ void Texture::load(const TextureCreationInput &input,
 
   populate();
 
-  if (gltf_image == nullptr) {
-    stbi_image_free(pixels);
-  } else {
-    delete[] pixels;
-  }
+  // the copy completed, the staging memory goes back to the allocator
+  staged.reset();
+  staged_levels.clear();
+  own_staging.reset();
 
   make_view();
 
   make_sampler();
-
-  make_descriptor_set();
-#ifndef NDEBUG
-  std::cout << "Finished Creating the ice_image::Texture Object\n\n"
-            << std::endl;
-#endif
 }
 
 Texture::~Texture() {
@@ -109,50 +210,95 @@ Texture::~Texture() {
   logical_device.destroySampler(sampler);
 }
 
-void Texture::load() {
+bool Texture::load() {
 #ifndef NDEBUG
   std::cout << "\nLoading Textures.....\n";
 #endif
   pixels = stbi_load(filename, &width, &height, &channels, STBI_rgb_alpha);
   if (pixels == nullptr) {
+    use_placeholder();
+    return false;
+  }
+  return true;
+}
+
+void Texture::use_placeholder() {
 #ifndef NDEBUG
-    std::cout << std::format("Unable to load: {}, reason: {}", filename,
-                             stbi_failure_reason())
-              << std::endl;
+  std::cout << std::format("Unable to load: {}, reason: {}", filename,
+                           stbi_failure_reason() != nullptr
+                               ? stbi_failure_reason()
+                               : "unsupported image")
+            << std::endl;
 #endif
-    width = height = 10;
-    channels = 4;
+  width = height = 10;
+  channels = 4;
 #ifndef NDEBUG
-    std::cout << std::format("Allocated random image of size {} x {}\n", width,
-                             height);
+  std::cout << std::format("Allocated random image of size {} x {}\n", width,
+                           height);
 #endif
-    pixels = new stbi_uc[static_cast<std::size_t>(width * height) * channels];
-    memset(pixels, 255, static_cast<std::size_t>(width * height) * channels);
-  }
+  // malloc, like the images stb_image decodes (freed with stbi_image_free)
+  pixels = static_cast<stbi_uc *>(
+      malloc(static_cast<std::size_t>(width * height) * channels));
+  memset(pixels, 255, static_cast<std::size_t>(width * height) * channels);
 }
 
-void Texture::populate() {
-  // First create a CPU-visible buffer...
-  const ice::BufferCreationInput input{
-      .size = static_cast<std::size_t>(width * height * 4),
-      .usage = vk::BufferUsageFlagBits::eTransferSrc,
+void Texture::stage_levels(const BakedTexture &texture) {
+  format = texture.format;
+  staged_levels.clear();
+  // 16 byte aligned levels suit the copies of any block size
+  vk::DeviceSize size = 0;
+  for (std::uint32_t level = 0; level < texture.levels.size(); ++level) {
+    const BakedLevel &baked = texture.levels[level];
+    staged_levels.push_back(
+        {.bufferOffset = size,
+         .bufferRowLength = 0,
+         .bufferImageHeight = 0,
+         .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                              .mipLevel = level,
+                              .baseArrayLayer = 0,
+                              .layerCount = 1},
+         .imageOffset = {.x = 0, .y = 0, .z = 0},
+         .imageExtent = {baked.width, baked.height, 1}});
+    size += (baked.data.size() + 15) & ~vk::DeviceSize{15};
+  }
 
-      .memory_properties = vk::MemoryPropertyFlagBits::eHostCoherent |
-                           vk::MemoryPropertyFlagBits::eHostVisible,
+  staged = staging_allocator->allocate(size);
+  for (std::size_t level = 0; level < texture.levels.size(); ++level) {
+    memcpy(staged.data() + staged_levels[level].bufferOffset,
+           texture.levels[level].data.data(),
+           texture.levels[level].data.size());
+  }
+}
 
-      .logical_device = logical_device,
-      .physical_device = physical_device,
-  };
+void Texture::bake(const std::string &source) {
+  std::vector<std::vector<unsigned char>> mips;
+  const BakedTexture baked =
+      make_baked_texture(pixels, static_cast<std::uint32_t>(width),
+                         static_cast<std::uint32_t>(height), mips);
+  if (!write_baked_texture(source, baked)) {
+#ifndef NDEBUG
+    std::cerr << std::format("Could not bake {}\n", source);
+#endif
+  }
 
-  const ice::BufferBundle staging_buffer = create_buffer(input);
+  stage_levels(baked);
+  stbi_image_free(pixels);
+  pixels = nullptr;
+}
 
-  // fill it,
-  void *write_location =
-      logical_device.mapMemory(staging_buffer.buffer_memory, 0, input.size);
-  memcpy(write_location, pixels, input.size);
-  logical_device.unmapMemory(staging_buffer.buffer_memory);
+void Texture::populate() {
+  // baked mips are copied as they are
+  if (!staged_levels.empty()) {
+    copy_mip_levels_to_image({.command_buffer = command_buffer,
+                              .queue = queue,
+                              .src_buffer = staged.buffer(),
+                              .dst_image = image,
+                              .mip_levels = mip_levels,
+                              .regions = staged_levels});
+    return;
+  }
 
-  // transition layout
+  // the pixels are already in the staging buffer, transition layout
   const ImageLayoutTransitionJob transition_job{
       .command_buffer = command_buffer,
       .queue = queue,
@@ -166,7 +312,7 @@ void Texture::populate() {
 
   const BufferImageCopyJob copy_job{.command_buffer = command_buffer,
                                     .queue = queue,
-                                    .src_buffer = staging_buffer.buffer,
+                                    .src_buffer = staged.buffer(),
                                     .dst_image = image,
                                     .width = width,
                                     .height = height};
@@ -176,22 +322,16 @@ void Texture::populate() {
   // no need to transition, this will transition to eShaderReadOnlyOptimal when
   // done.
   ice_image::generate_mipmaps(physical_device, command_buffer, image, queue,
-                              vk::Format::eR8G8B8A8Srgb, width, height,
-                              mip_levels);
+                              format, width, height, mip_levels);
 #ifndef NDEBUG
   std::cout << "Finished generating mipmaps\n";
 #endif
-
-  // Now the staging buffer can be destroyed
-  logical_device.freeMemory(staging_buffer.buffer_memory);
-  logical_device.destroyBuffer(staging_buffer.buffer);
 }
 
 void Texture::make_view() {
-  image_view = make_image_view(
-      logical_device, image,
-      /* vk::Format::eR8G8B8A8Unorm, */ vk::Format::eR8G8B8A8Srgb,
-      vk::ImageAspectFlagBits::eColor, vk::ImageViewType::e2D, 1, mip_levels);
+  image_view = make_image_view(logical_device, image, format,
+                               vk::ImageAspectFlagBits::eColor,
+                               vk::ImageViewType::e2D, 1, mip_levels);
 }
 
 void Texture::make_sampler() {
@@ -224,25 +364,28 @@ void Texture::make_sampler() {
 }
 
 void Texture::make_descriptor_set() {
-  descriptor_set =
-      ice::allocate_descriptor_sets(logical_device, descriptor_pool, layout);
-
-  const vk::DescriptorImageInfo image_descriptor{
-      .sampler = sampler,
-      .imageView = image_view,
-
-      .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-  };
-
-  const vk::WriteDescriptorSet descriptor_write{
-      .dstSet = descriptor_set,
-      .dstBinding = 0,
-      .dstArrayElement = 0,
-      .descriptorCount = 1,
-      .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-      .pImageInfo = &image_descriptor};
-
-  logical_device.updateDescriptorSets(descriptor_write, nullptr);
+  // shared textures are reached by every user, possibly from several jobs
+  std::call_once(descriptor_set_made, [this] {
+    descriptor_set =
+        ice::allocate_descriptor_sets(logical_device, descriptor_pool, layout);
+
+    const vk::DescriptorImageInfo image_descriptor{
+        .sampler = sampler,
+        .imageView = image_view,
+
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+    };
+
+    const vk::WriteDescriptorSet descriptor_write{
+        .dstSet = descriptor_set,
+        .dstBinding = 0,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .pImageInfo = &image_descriptor};
+
+    logical_device.updateDescriptorSets(descriptor_write, nullptr);
+  });
 }
 
 void Texture::use(vk::CommandBuffer recording_command_buffer,
@@ -3,7 +3,11 @@
 
 #include <tiny_gltf.h>
 
+#include <mutex>
+
 #include "../config.hpp"
+#include "../staging_allocator.hpp"
+#include "ice_baked_texture.hpp"
 #include "ice_image.hpp"
 
 namespace ice_image {
@@ -16,23 +20,68 @@ class Texture {
   // Construct and load
   explicit Texture(const TextureCreationInput &input);
   Texture(const TextureCreationInput &input,
-          const std::shared_ptr<tinygltf::Image> &gltf_image);
+          const tinygltf::Image *gltf_image);
 
   void use(vk::CommandBuffer recording_command_buffer,
            vk::PipelineLayout pipeline_layout);
 
   void load(const TextureCreationInput &input,
-            const std::shared_ptr<tinygltf::Image> &gltf_image =
-                nullptr);  // public load
+            const tinygltf::Image *gltf_image = nullptr);  // public load
   ~Texture();
 
+  /**
+   * Staged loading, equivalent to load() but split so every stage can run as
+   * its own job: decode() is CPU only, upload() records and submits the
+   * transfer and mipmap work, make_descriptor_set() allocates from the
+   * descriptor pool (which must not be accessed concurrently).
+   * decode() leaves the RGBA pixels in mapped staging memory, a glTF image
+   * kept encoded (as_is) is decoded here, decoded glTF pixels are expanded
+   * to RGBA straight into the staging memory.
+   */
+  void decode(const TextureCreationInput &input,
+              const tinygltf::Image *gltf_image = nullptr);
+  // decode() from the already read contents of the image file
+  void decode(const TextureCreationInput &input,
+              const std::vector<unsigned char> &encoded);
+  /**
+   * decode() from the bake of the image file of input (or the .ktx2 file it
+   * names), which brings its mip levels. False if there is none that is up
+   * to date and can be sampled on this device, decode() the file then (it
+   * bakes the file for the next time if runtime_baking() is on, else the
+   * mips are generated on upload). This one maps the file found by
+   * find_baked_texture(), the other takes its already read contents.
+   */
+  bool decode_baked(const TextureCreationInput &input);
+  bool decode_baked(const TextureCreationInput &input,
+                    std::string_view ktx2_file);
+  void upload(vk::CommandBuffer upload_command_buffer, vk::Queue upload_queue);
+
+  /**
+   * Allocate and write the descriptor set, only the first call does so (a
+   * texture shared through the TextureCache is reached by all its users).
+   * The set comes from the descriptor pool of the input the texture was
+   * decoded with, so it belongs to the loader that created the texture and
+   * that loader is the one to call this, from the job that owns the pool.
+   * This must be called after the image view and sampler have been made.
+   */
+  void make_descriptor_set();
+
  private:
   int width{}, height{}, channels{};
   std::uint32_t mip_levels{1};
+  vk::Format format{vk::Format::eR8G8B8A8Srgb};
   vk::Device logical_device;
   vk::PhysicalDevice physical_device;
   const char *filename{};
-  stbi_uc *pixels{};
+  stbi_uc *pixels{};  // RGBA, freed with stbi_image_free once staged
+  ice::StagingAllocator *staging_allocator{};
+  std::unique_ptr<ice::StagingAllocator> own_staging;  // if none was given
+  // the decoded pixels, from decode() until upload() copied them (declared
+  // after the allocator it returns to)
+  ice::StagingAllocator::Allocation staged;
+  // where each level of a baked mip chain is in staged, empty if the mips
+  // are generated on upload
+  std::vector<vk::BufferImageCopy> staged_levels;
 
   // Resources
   vk::Image image;
@@ -43,17 +92,37 @@ class Texture {
   // Resource Descriptors
   vk::DescriptorSetLayout layout;
   vk::DescriptorSet descriptor_set;
-  vk::DescriptorPool descriptor_pool;
+  vk::DescriptorPool descriptor_pool;  // descriptor_set is allocated from
+  std::once_flag descriptor_set_made;
 
   vk::CommandBuffer command_buffer;
   vk::Queue queue;
 
-  // Load the raw image data from the internally set filepath.
-  void load();
+  // Stores the handles and settings of input.
+  void bind_input(const TextureCreationInput &input);
+
+  // Load the raw image data from the internally set filepath, false if the
+  // placeholder is used instead.
+  bool load();
+
+  // Blank image used when the file could not be decoded.
+  void use_placeholder();
 
   /**
-   * Send loaded data to the image. The image must be loaded before calling
-   * this function.
+   * Copy the pixels (or expand the source with its components to RGBA) into
+   * staging memory and free them.
+   */
+  void stage(const unsigned char *source = nullptr, int components = 4);
+
+  // Stage every level of texture.
+  void stage_levels(const BakedTexture &texture);
+
+  // Make the mip chain of the pixels, bake it for source and stage it.
+  void bake(const std::string &source);
+
+  /**
+   * Send the staged data to the image. The image must be decoded before
+   * calling this function.
    */
   void populate();
 
@@ -65,13 +134,6 @@ class Texture {
 
   // Configure and create a sampler for the texture.
   void make_sampler();
-
-  /**
-   * Allocate and write the descriptor set. Currently, this is only being
-   * done once. This must be called after the image view and sampler have been
-   * made.
-   */
-  void make_descriptor_set();
 };
 }  // namespace ice_image
 
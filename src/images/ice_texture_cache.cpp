@@ -0,0 +1,70 @@
+#include "ice_texture_cache.hpp"
+
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <format>
+
+namespace ice_image {
+
+namespace {
+// Word at a time multiply-rotate hash, a large texture hashes in a fraction
+// of the time its decode takes
+uint64_t hash_bytes(std::span<const unsigned char> bytes) {
+  constexpr uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+  uint64_t hash = bytes.size() * PRIME;
+  std::size_t i = 0;
+  for (; i + 8 <= bytes.size(); i += 8) {
+    uint64_t word;
+    std::memcpy(&word, bytes.data() + i, sizeof(word));
+    hash = std::rotl(hash ^ (word * PRIME), 31) * PRIME;
+  }
+  if (i < bytes.size()) {
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+    hash = std::rotl(hash ^ (tail * PRIME), 31) * PRIME;
+  }
+
+  // final avalanche (splitmix64)
+  hash ^= hash >> 30;
+  hash *= 0xBF58476D1CE4E5B9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94D049BB133111EBULL;
+  return hash ^ (hash >> 31);
+}
+}  // namespace
+
+TextureCache::Entry TextureCache::acquire(const std::string &key) {
+  const std::lock_guard lock(mutex);
+  if (const auto cached = textures.find(key); cached != textures.end()) {
+    if (std::shared_ptr<Texture> texture = cached->second.lock()) {
+      return {.texture = std::move(texture), .created = false};
+    }
+  }
+
+  // drop the keys of the textures whose last user is gone, this one included
+  std::erase_if(textures, [](const auto &entry) {
+    return entry.second.expired();
+  });
+  auto texture = std::make_shared<Texture>();
+  textures.emplace(key, texture);
+  return {.texture = std::move(texture), .created = true};
+}
+
+std::string TextureCache::file_key(const std::string &path) {
+  std::error_code error;
+  const std::filesystem::path canonical =
+      std::filesystem::weakly_canonical(path, error);
+  return "file:" + (error ? std::filesystem::path(path).lexically_normal()
+                          : canonical)
+                       .generic_string();
+}
+
+std::string TextureCache::content_key(std::span<const unsigned char> pixels,
+                                      int width, int height, int components) {
+  // the byte count tells encoded images of the same dimensions apart when
+  // their hashes collide
+  return std::format("image:{}x{}x{}:{}:{:016x}", width, height, components,
+                     pixels.size(), hash_bytes(pixels));
+}
+}  // namespace ice_image
@@ -0,0 +1,47 @@
+#ifndef ICE_TEXTURE_CACHE_HPP
+#define ICE_TEXTURE_CACHE_HPP
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "ice_texture.hpp"
+
+namespace ice_image {
+
+/**
+ * Shares textures (image, sampler and descriptor set) between everything
+ * that uses the same source: files by their normalized path, embedded
+ * glTF images by a hash of their pixels. The cache only holds weak
+ * references, a texture is destroyed with its last user. Thread safe.
+ */
+class TextureCache {
+ public:
+  struct Entry {
+    std::shared_ptr<Texture> texture;
+    // the caller created the texture and has to load it, everybody else
+    // shares it as is
+    bool created{false};
+  };
+
+  // The texture of key, a fresh (unloaded) one if there is none alive.
+  // Entries of destroyed textures are erased on the way.
+  Entry acquire(const std::string &key);
+
+  // key of an image file, the same for every spelling of its path
+  static std::string file_key(const std::string &path);
+
+  // key of image data, decoded pixels or a still encoded image: its
+  // dimensions, byte count and 64-bit hash
+  static std::string content_key(std::span<const unsigned char> pixels,
+                                 int width, int height, int components);
+
+ private:
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<Texture>> textures;
+};
+}  // namespace ice_image
+
+#endif  // ICE_TEXTURE_CACHE_HPP
@@ -75,8 +75,26 @@ inline vk::ShaderModule create_shader_module(std::string filename,
   }
 }
 
+/**
+ * tinygltf image loader that keeps the encoded image (as_is), the textures
+ * decode it in their own jobs. External images are not read at all (see
+ * TINYGLTF_NO_EXTERNAL_IMAGE), they are decoded from their uri.
+ */
+// NOLINTBEGIN(misc-unused-parameters)
+inline bool keep_encoded_image(tinygltf::Image *image, const int image_index,
+                               std::string *err, std::string *warn,
+                               int req_width, int req_height,
+                               const unsigned char *bytes, int size,
+                               void *user_data) {
+  image->image.assign(bytes, bytes + size);
+  image->as_is = true;
+  return true;
+}
+// NOLINTEND(misc-unused-parameters)
+
 inline bool load_gltf_model(tinygltf::Model &model, const char *filename) {
   tinygltf::TinyGLTF loader;
+  loader.SetImageLoader(keep_encoded_image, nullptr);
   std::string err;
   std::string warn;
 
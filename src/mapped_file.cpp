@@ -0,0 +1,127 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ice {
+
+#ifdef _WIN32
+MappedFile::MappedFile(const char *filepath) {
+  HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+
+  LARGE_INTEGER file_size{};
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+    // the mapping keeps the file open
+    mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+      data = static_cast<const char *>(
+          MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      if (data != nullptr) {
+        size = static_cast<std::size_t>(file_size.QuadPart);
+      }
+    }
+  }
+  CloseHandle(file);
+}
+
+// NOLINTBEGIN (misc-unused-parameters)
+void MappedFile::discard(const char *end) const noexcept {}
+// NOLINTEND (misc-unused-parameters)
+
+void MappedFile::close() noexcept {
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+  }
+  if (mapping != nullptr) {
+    CloseHandle(mapping);
+  }
+  data = nullptr;
+  mapping = nullptr;
+  size = 0;
+}
+#else
+MappedFile::MappedFile(const char *filepath) {
+  const int file = ::open(filepath, O_RDONLY);
+  if (file < 0) {
+    return;
+  }
+
+  struct stat file_info {};
+  if (::fstat(file, &file_info) == 0 && file_info.st_size > 0) {
+    const auto file_size = static_cast<std::size_t>(file_info.st_size);
+    void *mapped =
+        ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapped != MAP_FAILED) {
+      // parsers read front to back
+      ::madvise(mapped, file_size, MADV_SEQUENTIAL);
+      data = static_cast<const char *>(mapped);
+      size = file_size;
+    }
+  }
+  // the mapping keeps the file open
+  ::close(file);
+}
+
+void MappedFile::discard(const char *end) const noexcept {
+  if (data == nullptr || end <= data) {
+    return;
+  }
+  // whole pages only, the one end points into is still being read
+  const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const auto length = static_cast<std::size_t>(end - data);
+  const std::size_t discarded = length - (length % page_size);
+  if (discarded > 0) {
+    ::madvise(const_cast<char *>(data), discarded, MADV_DONTNEED);
+  }
+}
+
+void MappedFile::close() noexcept {
+  if (data != nullptr) {
+    ::munmap(const_cast<char *>(data), size);
+  }
+  data = nullptr;
+  size = 0;
+}
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)) {
+#ifdef _WIN32
+  mapping = std::exchange(other.mapping, nullptr);
+#endif
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+#ifdef _WIN32
+    mapping = std::exchange(other.mapping, nullptr);
+#endif
+  }
+  return *this;
+}
+}  // namespace ice
@@ -0,0 +1,45 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string_view>
+
+namespace ice {
+
+/**
+ * Read-only view of a whole file mapped into memory, pages are only read
+ * from disk when touched and nothing is copied. Empty if the file could not
+ * be opened or mapped (or has no content).
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const char *filepath);
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  [[nodiscard]] std::string_view view() const { return {data, size}; }
+  [[nodiscard]] bool empty() const { return size == 0; }
+
+  // Drops the resident pages of the mapping up to end (a position in view()),
+  // for readers streaming through files larger than their memory budget. The
+  // pages are read again if touched. Does nothing on Windows, where the
+  // working set of a mapping is trimmed by the system.
+  void discard(const char *end) const noexcept;
+
+ private:
+  void close() noexcept;
+
+  const char *data{nullptr};
+  std::size_t size{0};
+#ifdef _WIN32
+  void *mapping{nullptr};  // HANDLE of the file mapping
+#endif
+};
+}  // namespace ice
+
+#endif  // MAPPED_FILE_HPP
@@ -1,8 +1,14 @@
 #include "mesh.hpp"
 
+#include <algorithm>
 #include <filesystem>
 
 #include "data_buffers.hpp"
+#include "gltf_accessor.hpp"
+#include "mapped_file.hpp"
+#include "mesh_cache.hpp"
+#include "obj_parsing.hpp"
+#include "vertex_transform.hpp"
 
 namespace ice {
 
@@ -11,125 +17,387 @@ ObjMesh::ObjMesh(const char *obj_filepath, const char *mtl_filepath,
   load(obj_filepath, mtl_filepath, pre_transform);
 }
 
-void ObjMesh::load(const char *obj_filepath, const char *mtl_filepath,
-                   glm::mat4 pre_transform) {
-  this->pre_transform = pre_transform;
+namespace {
+// large enough that a chunk is worth a job, skull.obj is a single one
+constexpr std::size_t OBJ_CHUNK_BYTES = std::size_t{4} << 20;
+// estimate of OBJ text per unique corner, to size the dedup maps up front
+// (skull.obj has about 86 bytes per corner)
+constexpr std::size_t OBJ_BYTES_PER_CORNER = 64;
+}  // namespace
 
-  std::ifstream file;
-  file.open(mtl_filepath);
-  std::string line;
-  std::string material_name;
-  std::vector<std::string> words;
+// Records of one piece of the OBJ file, with indices local to the piece
+struct ObjMesh::Chunk {
+  std::vector<glm::vec3> v, vn;
+  std::vector<glm::vec2> vt;
 
-  while (std::getline(file, line)) {
-    words = split(line, " ");
+  // unique corners in order of first appearance
+  std::vector<obj::CornerKey> corners;
+  // material of the chunk's last usemtl
+  std::optional<uint32_t> final_material;
 
-    if (words[0] == "newmtl") {
-      material_name = words[1];
-    }
-    if (words[0] == "Kd") {  // get diffuse color
-      brush_color = glm::vec3(std::stof(words[1]), std::stof(words[2]),
-                              std::stof(words[3]));
-      color_lookup.insert({material_name, brush_color});
+  std::vector<uint32_t> indices;  // into corners
+
+  // filled while merging
+  std::size_t v_offset{0}, vt_offset{0}, vn_offset{0}, index_offset{0};
+  std::vector<uint32_t> vertex_ids;  // corners to merged vertices
+};
+
+void ObjMesh::load(const char *obj_filepath, const char *mtl_filepath,
+                   glm::mat4 pre_transform,
+                   ice_threading::Scheduler *scheduler) {
+  this->pre_transform = pre_transform;
+
+  // a warm start maps the result of the last parse, copies are made straight
+  // from the mapping into the staging buffers
+  const bool first_load = vertices.empty() && cached_vertices.empty();
+  const std::array<std::string, 2> sources = {obj_filepath, mtl_filepath};
+  const std::optional<std::string> cache_path = mesh_cache_path(sources[0]);
+  if (first_load && cache_path) {
+    MappedFile cache_file(cache_path->c_str());
+    const std::optional<std::vector<MeshCachePart>> parts =
+        read_mesh_cache(cache_file, sources, pre_transform);
+    if (parts && parts->size() == 1) {
+      cache = std::move(cache_file);
+      cached_vertices = parts->front().vertices;
+      cached_indices = parts->front().indices;
+      return;
     }
   }
 
-  file.close();
+  // both files are tokenized in place, no line is copied
+  const MappedFile mtl_file(mtl_filepath);
+  read_materials(mtl_file.view());
 
-  file.open(obj_filepath);
+  const MappedFile obj_file(obj_filepath);
+  const std::vector<std::string_view> pieces =
+      obj::split_into_chunks(obj_file.view(), OBJ_CHUNK_BYTES);
 
-  while (std::getline(file, line)) {
-    words = split(line, " ");
+  std::vector<Chunk> chunks(pieces.size());
+  ice_threading::parallel_for(
+      scheduler, 0, chunks.size(), 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+          parse_chunk(pieces[i], chunks[i]);
+        }
+      });
 
-    if (words[0] == "v") {
-      read_vertex_data(words);
-    }
-    if (words[0] == "vt") {
-      read_texcoord_data(words);
-    }
-    if (words[0] == "vn") {
-      read_normal_data(words);
-    }
-    if (words[0] == "usemtl") {
-      if (color_lookup.contains(words[1])) {
-        brush_color = color_lookup[words[1]];
-      } else {
-        brush_color = glm::vec3(1.0f);  // just color white
-      }
-    }
-    if (words[0] == "f") {
-      read_face_data(words);
+  merge_chunks(chunks, scheduler);
+
+  if (first_load && cache_path) {
+    const std::array<MeshCachePart, 1> parts = {
+        MeshCachePart{.vertices = vertices, .indices = indices}};
+    if (!write_mesh_cache(sources, pre_transform, parts)) {
+#ifndef NDEBUG
+      std::cerr << std::format("Could not write the mesh cache of {}\n",
+                               obj_filepath);
+#endif
     }
   }
-
-  file.close();
 }
 
-void ObjMesh::read_vertex_data(const std::vector<std::string> &words) {
-  // extra component for homogenous coords
-  const glm::vec4 new_vertex = glm::vec4(
-      std::stof(words[1]), std::stof(words[2]), std::stof(words[3]), 1.0f);
-  const glm::vec3 transformed_vertex = glm::vec3(pre_transform * new_vertex);
-  v.push_back(transformed_vertex);
+std::span<const Vertex> ObjMesh::vertex_data() const {
+  return cache.empty() ? std::span<const Vertex>(vertices) : cached_vertices;
 }
 
-void ObjMesh::read_texcoord_data(const std::vector<std::string> &words) {
-  const glm::vec2 new_texcoord =
-      glm::vec2(std::stof(words[1]), std::stof(words[2]));
-  vt.push_back(new_texcoord);
+std::span<const uint32_t> ObjMesh::index_data() const {
+  return cache.empty() ? std::span<const uint32_t>(indices) : cached_indices;
 }
 
-void ObjMesh::read_normal_data(const std::vector<std::string> &words) {
-  // component of 0 for normal data
-  const glm::vec4 new_normal = glm::vec4(
-      std::stof(words[1]), std::stof(words[2]), std::stof(words[3]), 0.0f);
-  const glm::vec3 transformed_normal = glm::vec3(pre_transform * new_normal);
-  vn.push_back(transformed_normal);
-}
+void ObjMesh::read_materials(std::string_view text) {
+  // id 0 colors faces of materials missing from the MTL file white
+  if (material_colors.empty()) {
+    material_colors.emplace_back(1.0f);
+  }
 
-void ObjMesh::read_face_data(const std::vector<std::string> &words) {
-  const std::size_t triangle_count =
-      words.size() - 3;  // size - 2 , extra 1 for f
+  const obj::MaterialColors materials = obj::read_material_colors(text);
+  for (std::size_t i = 0; i < materials.names.size(); ++i) {
+    const auto id = static_cast<uint32_t>(material_colors.size());
+    if (material_lookup.insert({std::string(materials.names[i]), id})
+            .second) {
+      material_colors.push_back(materials.colors[i]);
+    }
+  }
+  if (materials.last) {
+    brush_color = *materials.last;
+  }
+
+  default_material = static_cast<uint32_t>(material_colors.size());
+  material_colors.push_back(brush_color);
+}
 
-  // triangles formed like this  1, 2, 3 then 1, 3, 4 then 1, 4, 5 ...
-  for (int i = 0; i < triangle_count; ++i) {
-    read_corner(words[1]);
-    read_corner(words[2 + i]);
-    read_corner(words[3 + i]);
+void ObjMesh::parse_chunk(std::string_view text, Chunk &chunk) const {
+  // unknown until the chunk's first usemtl
+  uint32_t material = obj::CornerKey::INHERITED;
+  FlatHashMap<obj::CornerKey, uint32_t, obj::CornerKeyHash> local_history;
+  local_history.reserve(text.size() / OBJ_BYTES_PER_CORNER);
+
+  const auto read_corner = [&](std::string_view vertex_description) {
+    const obj::CornerKey corner = obj::resolve_corner(
+        obj::parse_corner(vertex_description), chunk.v.size(), chunk.vt.size(),
+        chunk.vn.size(), material);
+    const auto [id, inserted] = local_history.try_emplace(
+        corner, static_cast<uint32_t>(chunk.corners.size()));
+    chunk.indices.push_back(id);
+    if (inserted) {
+      chunk.corners.push_back(corner);
+    }
+  };
+
+  while (!text.empty()) {
+    std::string_view line = obj::next_line(text);
+    const std::string_view keyword = obj::next_token(line);
+
+    if (keyword == "v") {
+      chunk.v.push_back(obj::parse_vec3(line));
+    } else if (keyword == "vt") {
+      const float s = obj::parse_float(obj::next_token(line));
+      const float t = obj::parse_float(obj::next_token(line));
+      chunk.vt.emplace_back(s, t);
+    } else if (keyword == "vn") {
+      chunk.vn.push_back(obj::parse_vec3(line));
+    } else if (keyword == "usemtl") {
+      const auto found =
+          material_lookup.find(std::string(obj::next_token(line)));
+      // just color white without a material
+      material = found != material_lookup.end() ? found->second : 0;
+      chunk.final_material = material;
+    } else if (keyword == "f") {
+      // triangles formed like this  1, 2, 3 then 1, 3, 4 then 1, 4, 5 ...
+      const std::string_view first = obj::next_token(line);
+      std::string_view previous = obj::next_token(line);
+      for (std::string_view corner = obj::next_token(line); !corner.empty();
+           corner = obj::next_token(line)) {
+        read_corner(first);
+        read_corner(previous);
+        read_corner(corner);
+        previous = corner;
+      }
+    }
   }
+
+  // in batches once the chunk is read, normals without the translation
+  transform_points(pre_transform, chunk.v);
+  transform_directions(glm::mat3(pre_transform), chunk.vn);
 }
 
-void ObjMesh::read_corner(const std::string &vertex_description) {
-  if (history.contains(vertex_description)) {
-    indices.push_back(history[vertex_description]);
-    return;
+void ObjMesh::merge_chunks(std::vector<Chunk> &chunks,
+                           ice_threading::Scheduler *scheduler) {
+  std::size_t v_count = 0, vt_count = 0, vn_count = 0, index_count = 0;
+  for (Chunk &chunk : chunks) {
+    chunk.v_offset = v_count;
+    chunk.vt_offset = vt_count;
+    chunk.vn_offset = vn_count;
+    chunk.index_offset = index_count;
+    v_count += chunk.v.size();
+    vt_count += chunk.vt.size();
+    vn_count += chunk.vn.size();
+    index_count += chunk.indices.size();
   }
 
-  auto index = static_cast<uint32_t>(history.size());
-  history.insert({vertex_description, index});
-  indices.push_back(index);
+  v.reserve(v.size() + v_count);
+  vt.reserve(vt.size() + vt_count);
+  vn.reserve(vn.size() + vn_count);
+  for (Chunk &chunk : chunks) {
+    v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+    vt.insert(vt.end(), chunk.vt.begin(), chunk.vt.end());
+    vn.insert(vn.end(), chunk.vn.begin(), chunk.vn.end());
+    chunk.v = {};
+    chunk.vt = {};
+    chunk.vn = {};
+  }
 
-  std::vector<std::string> v_vt_vn = split(vertex_description, "/");
+  // Corners get their vertex in order of first appearance in the file, the
+  // same order a single pass over the file assigns them in. Every unique
+  // corner of the chunks is at most one new vertex.
+  std::size_t corner_count = 0;
+  for (const Chunk &chunk : chunks) {
+    corner_count += chunk.corners.size();
+  }
+  history.reserve(history.size() + corner_count);
+  vertices.reserve(vertices.size() + corner_count);
+
+  uint32_t material = default_material;
+  for (Chunk &chunk : chunks) {
+    chunk.vertex_ids.resize(chunk.corners.size());
+    for (std::size_t i = 0; i < chunk.corners.size(); ++i) {
+      const obj::CornerKey corner =
+          obj::globalize_corner(chunk.corners[i], chunk.v_offset,
+                                chunk.vt_offset, chunk.vn_offset, material);
+      const auto [id, inserted] = history.try_emplace(
+          corner, static_cast<uint32_t>(vertices.size()));
+      chunk.vertex_ids[i] = id;
+      if (!inserted) {
+        continue;
+      }
 
+      vertices.push_back(make_vertex(corner));
+    }
+    if (chunk.final_material) {
+      material = *chunk.final_material;
+    }
+  }
+  brush_color = material_colors[material];
+
+  // translate every chunk's indices to the merged vertices
+  const std::size_t first_index = indices.size();
+  indices.resize(first_index + index_count);
+  ice_threading::parallel_for(
+      scheduler, 0, chunks.size(), 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t c = first; c < last; ++c) {
+          const Chunk &chunk = chunks[c];
+          uint32_t *output = indices.data() + first_index + chunk.index_offset;
+          for (const uint32_t corner : chunk.indices) {
+            *output++ = chunk.vertex_ids[corner];
+          }
+        }
+      });
+}
+
+Vertex ObjMesh::make_vertex(const obj::CornerKey &corner) const {
   // prepare attributes
-  // position
-  const glm::vec3 pos =
-      v[std::stol(v_vt_vn[0]) - 1];  // obj uses 1 based indexing
+  const glm::vec3 pos = corner.position() != obj::CornerKey::NONE
+                            ? v[corner.position()]
+                            : glm::vec3(0.0f);
+  const glm::vec2 texcoord = corner.texcoord() != obj::CornerKey::NONE
+                                 ? vt[corner.texcoord()]
+                                 : glm::vec2(0.0f, 0.0f);
+  const glm::vec3 normal = corner.normal() != obj::CornerKey::NONE
+                               ? vn[corner.normal()]
+                               : glm::vec3(0.0f);
+
+  return Vertex{.pos = pos,
+                .color = material_colors[corner.material()],
+                .tex_coord = texcoord,
+                .normal = normal};
+}
 
-  // texcoord
-  glm::vec2 texcoord = glm::vec2(0.0f, 0.0f);
-  if (v_vt_vn.size() == 3 && !v_vt_vn[1].empty()) {
-    texcoord = vt[std::stol(v_vt_vn[1]) - 1];
+void ObjMesh::stream(const char *obj_filepath, const char *mtl_filepath,
+                     glm::mat4 pre_transform, std::size_t batch_bytes,
+                     uint32_t first_vertex, BatchSink emit) {
+  this->pre_transform = pre_transform;
+  const MappedFile mtl_file(mtl_filepath);
+  read_materials(mtl_file.view());
+
+  // A corner of a batch costs its index, at most one vertex and its share of
+  // the dedup map, which is kept below 3/4 full (up to 8/3 slots per entry)
+  constexpr std::size_t BYTES_PER_CORNER =
+      sizeof(uint32_t) + sizeof(Vertex) +
+      3 * (sizeof(obj::CornerKey) + sizeof(uint64_t));
+  const std::size_t batch_corners =
+      std::max<std::size_t>(batch_bytes / BYTES_PER_CORNER, 3);
+
+  // sized once, clearing keeps the capacity
+  FlatHashMap<obj::CornerKey, uint32_t, obj::CornerKeyHash> batch_history;
+  std::vector<Vertex> batch_vertices;
+  std::vector<uint32_t> batch_indices;
+  batch_history.reserve(batch_corners);
+  batch_vertices.reserve(batch_corners);
+  batch_indices.reserve(batch_corners);
+
+  const MappedFile obj_file(obj_filepath);
+  std::string_view text = obj_file.view();
+  uint32_t material = default_material;
+  std::size_t transformed_v = v.size(), transformed_vn = vn.size();
+
+  const auto flush = [&] {
+    if (batch_indices.empty()) {
+      return;
+    }
+    emit(batch_vertices, batch_indices);
+    first_vertex += static_cast<uint32_t>(batch_vertices.size());
+    batch_history.clear();
+    batch_vertices.clear();
+    batch_indices.clear();
+    // the text before this line has been parsed
+    obj_file.discard(text.data());
+  };
+
+  const auto read_corner = [&](std::string_view vertex_description) {
+    // read front to back, so every index resolves right away
+    const obj::CornerKey corner = obj::globalize_corner(
+        obj::resolve_corner(obj::parse_corner(vertex_description), v.size(),
+                            vt.size(), vn.size(), material),
+        0, 0, 0, material);
+    const auto [id, inserted] = batch_history.try_emplace(
+        corner, first_vertex + static_cast<uint32_t>(batch_vertices.size()));
+    batch_indices.push_back(id);
+    if (inserted) {
+      batch_vertices.push_back(make_vertex(corner));
+    }
+  };
+
+  while (!text.empty()) {
+    std::string_view line = obj::next_line(text);
+    const std::string_view keyword = obj::next_token(line);
+
+    if (keyword == "v") {
+      v.push_back(obj::parse_vec3(line));
+    } else if (keyword == "vt") {
+      const float s = obj::parse_float(obj::next_token(line));
+      const float t = obj::parse_float(obj::next_token(line));
+      vt.emplace_back(s, t);
+    } else if (keyword == "vn") {
+      vn.push_back(obj::parse_vec3(line));
+    } else if (keyword == "usemtl") {
+      const auto found =
+          material_lookup.find(std::string(obj::next_token(line)));
+      // just color white without a material
+      material = found != material_lookup.end() ? found->second : 0;
+    } else if (keyword == "f") {
+      // records read since the last face, in one batch
+      transform_points(pre_transform, std::span(v).subspan(transformed_v));
+      transform_directions(glm::mat3(pre_transform),
+                           std::span(vn).subspan(transformed_vn));
+      transformed_v = v.size();
+      transformed_vn = vn.size();
+
+      // triangles formed like this  1, 2, 3 then 1, 3, 4 then 1, 4, 5 ...
+      const std::string_view first = obj::next_token(line);
+      std::string_view previous = obj::next_token(line);
+      for (std::string_view corner = obj::next_token(line); !corner.empty();
+           corner = obj::next_token(line)) {
+        if (batch_indices.size() + 3 > batch_corners) {
+          flush();
+        }
+        read_corner(first);
+        read_corner(previous);
+        read_corner(corner);
+        previous = corner;
+      }
+    }
   }
+  flush();
+
+  brush_color = material_colors[material];
+  v = {};
+  vt = {};
+  vn = {};
+}
 
-  // normals
-  const glm::vec3 normal = vn[std::stol(v_vt_vn[2]) - 1];
+std::size_t ObjMesh::count_indices(const char *obj_filepath) {
+  const MappedFile obj_file(obj_filepath);
+  std::string_view text = obj_file.view();
+  const char *discarded = text.data();
+
+  std::size_t index_count = 0;
+  while (!text.empty()) {
+    std::string_view line = obj::next_line(text);
+    if (obj::next_token(line) == "f") {
+      std::size_t corner_count = 0;
+      while (!obj::next_token(line).empty()) {
+        ++corner_count;
+      }
+      if (corner_count >= 3) {
+        index_count += 3 * (corner_count - 2);
+      }
+    }
 
-  // Append Vertex
-  vertices.push_back(Vertex{.pos = pos,
-                            .color = brush_color,
-                            .tex_coord = texcoord,
-                            .normal = normal});
+    // counting must not make the file resident either
+    if (static_cast<std::size_t>(text.data() - discarded) >= OBJ_CHUNK_BYTES) {
+      discarded = text.data();
+      obj_file.discard(discarded);
+    }
+  }
+  return index_count;
 }
 
 ///////////////////////////////////////////////////////////////
@@ -150,23 +418,34 @@ std::string make_path_relative_to_gltf(const std::string &gltf_filepath,
 
   return full_path.string();
 }
+
+// image of the base color texture of primitive, -1 if it has none
+int base_color_image(const tinygltf::Model &model,
+                     const tinygltf::Primitive &primitive) {
+  if (primitive.material < 0 ||
+      primitive.material >= static_cast<int>(model.materials.size())) {
+    return -1;
+  }
+  const int texture_index = model.materials[primitive.material]
+                                .pbrMetallicRoughness.baseColorTexture.index;
+  if (texture_index < 0 ||
+      texture_index >= static_cast<int>(model.textures.size())) {
+    return -1;
+  }
+  const int image = model.textures[texture_index].source;
+  return image < static_cast<int>(model.images.size()) ? image : -1;
+}
 }  // namespace
 
 GltfMesh::~GltfMesh() {
-  for (auto &mesh_buffer : mesh_buffers) {
-    // Destroy  mesh vertex and index buffers
-    device.destroyBuffer(mesh_buffer.vertex_buffer.buffer);
-    device.freeMemory(mesh_buffer.vertex_buffer.buffer_memory);
-
-    device.destroyBuffer(mesh_buffer.index_buffer.buffer);
-    device.freeMemory(mesh_buffer.index_buffer.buffer_memory);
-  }
+  // Destroy the shared vertex and index buffers
+  destroy_buffer(device, vertex_buffer);
+  destroy_buffer(device, index_buffer);
 
+  // textures are shared, the last user destroys them
+  textures.clear();
+  image_textures.clear();
   device.destroyDescriptorPool(descriptor_pool);
-
-  for (auto &texture : textures) {
-    delete texture;
-  }
 }
 
 GltfMesh::GltfMesh(vk::PhysicalDevice physical_device, vk::Device device,
@@ -185,7 +464,37 @@ GltfMesh::GltfMesh(vk::PhysicalDevice physical_device, vk::Device device,
   load(gltf_filepath);
 }
 
+GltfMesh::GltfMesh(vk::PhysicalDevice physical_device, vk::Device device,
+                   vk::CommandBuffer command_buffer, vk::Queue queue,
+                   vk::DescriptorSetLayout descriptor_set_layout,
+                   vk::DescriptorPool descriptor_pool, glm::mat4 pre_transform,
+                   ice_threading::Scheduler *scheduler,
+                   ice_image::TextureCache *texture_cache,
+                   ice::StagingAllocator *texture_staging)
+    : physical_device(physical_device),
+      device(device),
+      command_buffer(command_buffer),
+      queue(queue),
+      descriptor_set_layout(descriptor_set_layout),
+      descriptor_pool(descriptor_pool),
+      pre_transform(pre_transform),
+      scheduler(scheduler),
+      texture_cache(texture_cache),
+      texture_staging(texture_staging) {}
+
 void GltfMesh::load(const char *gltf_filepath) {
+  parse(gltf_filepath);
+  for (std::size_t i = 0; i < primitives.size(); ++i) {
+    decode_primitive(i);
+  }
+  for (std::size_t i = 0; i < image_textures.size(); ++i) {
+    decode_image(i);
+  }
+  upload(command_buffer, queue);
+}
+
+void GltfMesh::parse(const char *gltf_filepath) {
+  this->gltf_filepath = gltf_filepath;
   if (!ice::load_gltf_model(model, gltf_filepath)) {
 #ifndef NDEBUG
     std::cerr << "Loading of " << gltf_filepath << " failed";
@@ -196,7 +505,9 @@ void GltfMesh::load(const char *gltf_filepath) {
   debug_model();
 #endif
 
-  bind_models();
+  collect_primitives();
+  acquire_textures();
+  map_cache();
 }
 
 glm::mat4 GltfMesh::get_local_transform(const tinygltf::Node &node) {
@@ -228,39 +539,143 @@ glm::mat4 GltfMesh::get_local_transform(const tinygltf::Node &node) {
   return transform;
 }
 
-void GltfMesh::bind_models() {
-  const tinygltf::Scene &scene = model.scenes[model.defaultScene];
+// Every mesh used by the scene gets its primitives once, the nodes that
+// reference it become its instances
+void GltfMesh::collect_primitives() {
+  primitives.clear();
+  const std::vector<GltfInstances> mesh_instances = collect_instances();
 
+  for (std::size_t mesh = 0; mesh < model.meshes.size(); ++mesh) {
+    if (mesh_instances[mesh].count == 0) {
+      continue;
+    }
+    for (const tinygltf::Primitive &primitive : model.meshes[mesh].primitives) {
+      primitives.push_back({.primitive = &primitive,
+                            .instances = mesh_instances[mesh],
+                            .image = base_color_image(model, primitive)});
+    }
+  }
+}
+
+// Rebuilds instance_transforms from the node hierarchy and pre_transform,
+// returns the instances of every mesh (unused ones have none). The node
+// hierarchy is fixed, so the ranges stay the same across calls.
+std::vector<GltfInstances> GltfMesh::collect_instances() {
+  const tinygltf::Scene &scene = model.scenes[model.defaultScene];
+  std::vector<std::vector<glm::mat4>> mesh_transforms(model.meshes.size());
   for (const int node : scene.nodes) {
     assert((node >= 0) && (node < model.nodes.size()));
-    bind_model_nodes(model.nodes[node], pre_transform);
+    collect_node_transforms(model.nodes[node], pre_transform,
+                            mesh_transforms);
+  }
+
+  instance_transforms.clear();
+  std::vector<GltfInstances> mesh_instances(model.meshes.size());
+  for (std::size_t mesh = 0; mesh < model.meshes.size(); ++mesh) {
+    const std::vector<glm::mat4> &transforms = mesh_transforms[mesh];
+    mesh_instances[mesh] = {
+        .first = static_cast<uint32_t>(instance_transforms.size()),
+        .count = static_cast<uint32_t>(transforms.size())};
+    for (const glm::mat4 &transform : transforms) {
+      instance_transforms.push_back(make_instance_transform(transform));
+    }
+  }
+  ++transform_version;
+  return mesh_instances;
+}
+
+// the glTF file names the cache, external buffers are part of its key (the
+// data is in mesh space, node transforms and pre_transform do not change it)
+std::vector<std::string> GltfMesh::cache_sources() const {
+  std::vector<std::string> sources = {gltf_filepath};
+  for (const tinygltf::Buffer &buffer : model.buffers) {
+    if (!buffer.uri.empty() && !buffer.uri.starts_with("data:")) {
+      sources.push_back(make_path_relative_to_gltf(gltf_filepath, buffer.uri));
+    }
+  }
+  return sources;
+}
+
+void GltfMesh::map_cache() {
+  release_cache();
+  const std::vector<std::string> sources = cache_sources();
+  const std::optional<std::string> cache_path =
+      mesh_cache_path(sources.front());
+  if (!cache_path) {
+    return;
+  }
+  MappedFile cache_file(cache_path->c_str());
+  const std::optional<std::vector<MeshCachePart>> parts =
+      read_mesh_cache(cache_file, sources, glm::mat4(1.0f));
+  if (!parts || parts->size() != primitives.size()) {
+    return;
+  }
+
+  cache = std::move(cache_file);
+  for (std::size_t i = 0; i < primitives.size(); ++i) {
+    primitives[i].cached_vertices = (*parts)[i].vertices;
+    primitives[i].cached_indices = (*parts)[i].indices;
+  }
+}
+
+void GltfMesh::write_cache() const {
+  const std::vector<std::string> sources = cache_sources();
+  if (!mesh_cache_path(sources.front())) {
+    return;
+  }
+  std::vector<MeshCachePart> parts;
+  parts.reserve(primitives.size());
+  for (const GltfPrimitiveData &data : primitives) {
+    parts.push_back({.vertices = data.vertices, .indices = data.indices});
   }
+  if (!write_mesh_cache(sources, glm::mat4(1.0f), parts)) {
+#ifndef NDEBUG
+    std::cerr << std::format("Could not write the mesh cache of {}\n",
+                             gltf_filepath);
+#endif
+  }
+}
+
+void GltfMesh::release_cache() {
+  for (GltfPrimitiveData &data : primitives) {
+    data.cached_vertices = {};
+    data.cached_indices = {};
+  }
+  cache = MappedFile();
 }
 
-// recursively binds nodes
+// recursively collects the global transforms of nodes, by the mesh they
+// reference
 // NOLINTBEGIN(misc-no-recursion)
-void GltfMesh::bind_model_nodes(tinygltf::Node &node,
-                                glm::mat4 parent_transform) {
+void GltfMesh::collect_node_transforms(
+    const tinygltf::Node &node, glm::mat4 parent_transform,
+    std::vector<std::vector<glm::mat4>> &mesh_transforms) const {
   const glm::mat4 local_transform = get_local_transform(node);
   const glm::mat4 global_transform = parent_transform * local_transform;
 
   if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
-    bind_mesh(model.meshes[node.mesh], global_transform);
+    mesh_transforms[node.mesh].push_back(global_transform);
   }
 
   for (const int i : node.children) {
     assert((i >= 0) && (i < model.nodes.size()));
-    bind_model_nodes(model.nodes[i], global_transform);
+    collect_node_transforms(model.nodes[i], global_transform, mesh_transforms);
   }
 }
 // NOLINTEND(misc-no-recursion)
 
-void GltfMesh::bind_mesh(tinygltf::Mesh &mesh,
-                         const glm::mat4 &global_transform) {
-  for (const tinygltf::Primitive &primitive : mesh.primitives) {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
+void GltfMesh::decode_primitive(std::size_t index) {
+  // already mapped from the cache
+  if (!cache.empty()) {
+    return;
+  }
+
+  GltfPrimitiveData &data = primitives[index];
+  const tinygltf::Primitive &primitive = *data.primitive;
+  std::vector<Vertex> &vertices = data.vertices;
+  std::vector<uint32_t> &indices = data.indices;
 
+  {
     // Get accessors (with error checking)
     auto get_accessor =
         [&](const char *attr_name) -> const tinygltf::Accessor * {
@@ -287,122 +702,90 @@ void GltfMesh::bind_mesh(tinygltf::Mesh &mesh,
     // Ensure we at least have position data
     if (!pos_accessor) {
       std::cerr << "Position is Required " << std::endl;
-      continue;
+      return;
     }
 
-    // Reserve space for vertices
-    const std::size_t vertex_count = pos_accessor->count;
-    vertices.reserve(vertex_count);
-
-    // Helper function to get buffer data
-    auto get_buffer_data =
-        [this](const tinygltf::Accessor *accessor) -> const uint8_t * {
-      if (!accessor) return nullptr;
-      const tinygltf::BufferView &buffer_view =
-          model.bufferViews[accessor->bufferView];
-      const tinygltf::Buffer &buffer = model.buffers[buffer_view.buffer];
-      return &buffer.data[buffer_view.byteOffset + accessor->byteOffset];
+    // resolve strides, component types and sparse data once
+    auto get_view = [&](const tinygltf::Accessor *accessor)
+        -> std::optional<GltfAccessorView> {
+      if (!accessor) return std::nullopt;
+      std::optional<GltfAccessorView> view = view_accessor(model, *accessor);
+#ifndef NDEBUG
+      if (!view) {
+        std::cerr << "Warning: Invalid glTF accessor. Skipping.\n";
+      }
+#endif
+      return view;
     };
+    const std::optional<GltfAccessorView> pos_view = get_view(pos_accessor);
+    const std::optional<GltfAccessorView> normal_view =
+        get_view(normal_accessor);
+    const std::optional<GltfAccessorView> texcoord_view =
+        get_view(texcoord_accessor);
+    const std::optional<GltfAccessorView> color_view =
+        get_view(color_accessor);
+    if (!pos_view) {
+      return;
+    }
 
-    const auto *pos_data =
-        reinterpret_cast<const float *>(get_buffer_data(pos_accessor));
-    const auto *normal_data =
-        reinterpret_cast<const float *>(get_buffer_data(normal_accessor));
-    const auto *texcoord_data =
-        reinterpret_cast<const float *>(get_buffer_data(texcoord_accessor));
-    const auto *color_data =
-        reinterpret_cast<const float *>(get_buffer_data(color_accessor));
-
-    for (size_t i = 0; i < vertex_count; ++i) {
-      Vertex vertex{};
-
-      vertex.pos =
-          glm::vec3(pos_data[i * 3], pos_data[i * 3 + 1], pos_data[i * 3 + 2]);
+    // Size up front, chunks of vertices are decoded in parallel
+    const std::size_t vertex_count = pos_view->count;
+    vertices.resize(vertex_count);
 
-      // Normal (optional)
+    // attributes shorter than the positions fall back to the defaults
+    auto usable = [vertex_count](const std::optional<GltfAccessorView> &view)
+        -> const GltfAccessorView * {
+      return view && view->count >= vertex_count ? &*view : nullptr;
+    };
+    const GltfAccessorView *normal_data = usable(normal_view);
+    const GltfAccessorView *texcoord_data = usable(texcoord_view);
+    const GltfAccessorView *color_data = usable(color_view);
+
+    // Each attribute is decoded for a whole chunk into a packed array, then
+    // the arrays are interleaved into vertices without per vertex branches.
+    // Vertices stay in mesh space, node transforms are applied per instance.
+    auto decode_vertices = [&](std::size_t first, std::size_t last) {
+      const std::size_t count = last - first;
+      std::vector<glm::vec3> positions(count);
+      std::vector<glm::vec3> normals(count, glm::vec3(0.0f, 1.0f, 0.0f));
+      std::vector<glm::vec2> texcoords(count, glm::vec2(0.0f, 0.0f));
+      std::vector<glm::vec3> colors(count, glm::vec3(1.0f, 1.0f, 1.0f));
+
+      decode_accessor(*pos_view, first, last, glm::value_ptr(positions[0]),
+                      3);
       if (normal_data) {
-        vertex.normal = glm::vec3(normal_data[i * 3], normal_data[i * 3 + 1],
-                                  normal_data[i * 3 + 2]);
-      } else {
-        vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);  // Default normal
+        decode_accessor(*normal_data, first, last, glm::value_ptr(normals[0]),
+                        3);
       }
-
-      // Apply global transform to vertices
-      const glm::vec4 transformed =
-          global_transform * glm::vec4(vertex.pos, 1.0f);
-      vertex.pos = glm::vec3(transformed) / transformed.w;
-      vertex.normal =
-          glm::mat3(glm::transpose(glm::inverse(global_transform))) *
-          vertex.normal;
-
-      // Texture coordinates (optional)
       if (texcoord_data) {
-        vertex.tex_coord =
-            glm::vec2(texcoord_data[i * 2], texcoord_data[i * 2 + 1]);
-      } else {
-        vertex.tex_coord = glm::vec2(0.0f, 0.0f);  // Default UV
+        decode_accessor(*texcoord_data, first, last,
+                        glm::value_ptr(texcoords[0]), 2);
       }
-
-      // Color (optional)
       if (color_data) {
-        if (color_accessor->componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-          vertex.color = glm::vec3(color_data[i * 3], color_data[i * 3 + 1],
-                                   color_data[i * 3 + 2]);
-        } else if (color_accessor->componentType ==
-                   TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-          const auto *color_data_byte =
-              reinterpret_cast<const uint8_t *>(color_data);
-          vertex.color = glm::vec3(
-              static_cast<float>(color_data_byte[i * 3]) / 255.0f,
-              static_cast<float>(color_data_byte[i * 3 + 1]) / 255.0f,
-              static_cast<float>(color_data_byte[i * 3 + 2]) / 255.0f);
-        }
-      } else {
-        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // Default color (white)
+        // vec4 colors drop their alpha
+        decode_accessor(*color_data, first, last, glm::value_ptr(colors[0]),
+                        3);
       }
 
-      vertices.push_back(vertex);
-    }
-
-    // TODO(uzoochogu): BENCHMARK THIS
-    // // Apply global transform to vertices as a batch -
-    // for (auto &vertex : vertices) {
-    //   glm::vec4 transformed = global_transform * glm::vec4(vertex.pos, 1.0f);
-    //   vertex.pos = glm::vec3(transformed) / transformed.w;
-    //   vertex.normal =
-    //       glm::mat3(glm::transpose(glm::inverse(global_transform))) *
-    //       vertex.normal;
-    // }
+      for (std::size_t i = 0; i < count; ++i) {
+        vertices[first + i] = Vertex{.pos = positions[i],
+                                     .color = colors[i],
+                                     .tex_coord = texcoords[i],
+                                     .normal = normals[i]};
+      }
+    };
+    ice_threading::parallel_for(scheduler, 0, vertex_count, 4096,
+                                decode_vertices);
 
     // Read index data (if available)
     if (primitive.indices >= 0) {
-      const tinygltf::Accessor &index_accessor =
-          model.accessors[primitive.indices];
-      const tinygltf::BufferView &index_buffer_view =
-          model.bufferViews[index_accessor.bufferView];
-      const tinygltf::Buffer &index_buffer =
-          model.buffers[index_buffer_view.buffer];
-      const uint8_t *index_data =
-          &index_buffer
-               .data[index_buffer_view.byteOffset + index_accessor.byteOffset];
-
-      indices.reserve(index_accessor.count);
-
-      if (index_accessor.componentType ==
-          TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-        const auto *index_data_short =
-            reinterpret_cast<const uint16_t *>(index_data);
-        for (size_t i = 0; i < index_accessor.count; ++i) {
-          indices.push_back(static_cast<uint32_t>(index_data_short[i]));
-        }
-      } else if (index_accessor.componentType ==
-                 TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
-        const auto *index_data_int =
-            reinterpret_cast<const uint32_t *>(index_data);
-        for (size_t i = 0; i < index_accessor.count; ++i) {
-          indices.push_back(index_data_int[i]);
-        }
-      } else {
+      const std::optional<GltfAccessorView> index_view =
+          get_view(&model.accessors[primitive.indices]);
+      if (index_view) {
+        indices.resize(index_view->count);
+      }
+      if (!index_view || !decode_indices(*index_view, indices)) {
+        indices.clear();
 #ifndef NDEBUG
         std::cerr
             << "Warning: Unsupported index component type. Skipping indices."
@@ -416,61 +799,232 @@ void GltfMesh::bind_mesh(tinygltf::Mesh &mesh,
         indices.push_back(static_cast<uint32_t>(i));
       }
     }
+  }
+}
+
+void GltfMesh::upload(vk::CommandBuffer upload_command_buffer,
+                      vk::Queue upload_queue) {
+  if (cache.empty()) {
+    write_cache();
+  }
+
+  const StagedGeometry staged = stage_geometry();
+  if (!primitive_ranges.empty()) {
+    upload_command_buffer.reset();
+    upload_command_buffer.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    record_geometry_copy(upload_command_buffer, staged);
+    upload_command_buffer.end();
+    if (submit_and_wait(upload_command_buffer, upload_queue) !=
+        vk::Result::eSuccess) {
+#ifndef NDEBUG
+      std::cerr << "glTF buffer upload failed!\n";
+#endif
+    }
+    destroy_buffer(device, staged.vertices);
+    destroy_buffer(device, staged.indices);
+  }
+
+  upload_textures(upload_command_buffer, upload_queue);
+  release_cache();
+}
 
-    // Buffers creation
-    const ice::BufferBundle vertex_buffer_bundle = create_device_local_buffer(
-        physical_device, device, command_buffer, queue,
-        vk::BufferUsageFlagBits::eVertexBuffer, vertices);
-    const ice::BufferBundle index_buffer_bundle = create_device_local_buffer(
-        physical_device, device, command_buffer, queue,
-        vk::BufferUsageFlagBits::eIndexBuffer, indices);
-
-    // Store the buffer pair
-    mesh_buffers.push_back({vertex_buffer_bundle, index_buffer_bundle});
-    index_counts.push_back(static_cast<uint32_t>(indices.size()));
-
-    // Handle material and texture
-    if (primitive.material >= 0) {
-      const tinygltf::Material &material = model.materials[primitive.material];
-
-      // Check for base color texture
-      if (material.pbrMetallicRoughness.baseColorTexture.index >= 0) {
-        const int texture_index =
-            material.pbrMetallicRoughness.baseColorTexture.index;
-        const tinygltf::Texture &gltf_texture = model.textures[texture_index];
-        const tinygltf::Image &gltf_image = model.images[gltf_texture.source];
-
-        // Create texture
-        ice_image::TextureCreationInput texture_input{
-            .physical_device = physical_device,
-            .logical_device = device,
-            .command_buffer = command_buffer,
-            .queue = queue,
-            .layout = descriptor_set_layout,
-            .descriptor_pool = descriptor_pool,
-            .filenames = {}};
-
-        ice_image::Texture *texture;
-        if (!gltf_image.uri.empty()) {
-          // External image file
-          const std::string relative_path =
-              make_path_relative_to_gltf(gltf_filepath, gltf_image.uri);
-          texture_input.filenames.emplace_back(relative_path.c_str());
+ice_threading::Task<> GltfMesh::upload_async(
+    ice_threading::SubmissionThread &submission) {
+  if (cache.empty()) {
+    write_cache();
+  }
+
+  // the geometry of all primitives goes in one submission
+  const StagedGeometry staged = stage_geometry();
+  if (!primitive_ranges.empty()) {
+    const ice_threading::SubmissionThread::TransientCommands commands =
+        submission.make_transient_commands();
+    commands.command_buffer.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    record_geometry_copy(commands.command_buffer, staged);
+    commands.command_buffer.end();
+
+    const vk::Result result =
+        co_await ice_threading::gpu_submit(submission, *scheduler, commands);
+    if (result != vk::Result::eSuccess) {
 #ifndef NDEBUG
-          std::cout << "\nFILENAME\n " << texture_input.filenames[0] << "\n\n";
+      std::cerr << std::format("glTF buffer upload failed: {}\n",
+                               vk::to_string(result));
 #endif
-          texture = new ice_image::Texture(texture_input);
-        } else if (!gltf_image.image.empty()) {
-          // read image data from embedded buffer
-          texture = new ice_image::Texture(
-              texture_input, std::make_shared<tinygltf::Image>(gltf_image));
+    }
+    destroy_buffer(device, staged.vertices);
+    destroy_buffer(device, staged.indices);
+  }
+
+  // textures still upload through the blocking path, with the command buffer
+  // of the thread we were resumed on
+  const ice_threading::WorkerContext context =
+      ice_threading::Scheduler::current_context();
+  upload_textures(context.command_buffer, context.queue);
+  release_cache();
+}
+
+// Lays the decoded primitives out back to back, as MeshCollator does with
+// the OBJ meshes, and copies them into two staging buffers
+GltfMesh::StagedGeometry GltfMesh::stage_geometry() {
+  primitive_ranges.clear();
+  index_counts.clear();
+  primitive_instances.clear();
+
+  StagedGeometry staged;
+  std::vector<const GltfPrimitiveData *> uploaded;
+  std::size_t vertex_count = 0;
+  for (const GltfPrimitiveData &data : primitives) {
+    // skipped while decoding
+    if (data.vertex_data().empty()) {
+      continue;
+    }
+    primitive_ranges.push_back(
+        {.first_index = static_cast<uint32_t>(staged.index_bytes /
+                                              sizeof(uint32_t)),
+         .vertex_offset = static_cast<int32_t>(vertex_count)});
+    index_counts.push_back(static_cast<uint32_t>(data.index_data().size()));
+    primitive_instances.push_back(data.instances);
+    uploaded.push_back(&data);
+
+    vertex_count += data.vertex_data().size();
+    staged.vertex_bytes += data.vertex_data().size_bytes();
+    staged.index_bytes += data.index_data().size_bytes();
+  }
+  if (uploaded.empty()) {
+    return staged;
+  }
+
+  BufferCreationInput buffer_input = {
+      .size = staged.vertex_bytes,
+      .usage = vk::BufferUsageFlagBits::eTransferSrc,
+      .logical_device = device,
+      .physical_device = physical_device};
+  staged.vertices = create_buffer(buffer_input);
+  buffer_input.size = staged.index_bytes;
+  staged.indices = create_buffer(buffer_input);
+
+  auto *vertex_memory = static_cast<Vertex *>(device.mapMemory(
+      staged.vertices.buffer_memory, 0, staged.vertex_bytes));
+  auto *index_memory = static_cast<uint32_t *>(
+      device.mapMemory(staged.indices.buffer_memory, 0, staged.index_bytes));
+  ice_threading::parallel_for(
+      scheduler, 0, uploaded.size(), 1,
+      [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+          const std::span<const Vertex> vertices = uploaded[i]->vertex_data();
+          const std::span<const uint32_t> indices = uploaded[i]->index_data();
+          std::ranges::copy(vertices,
+                            vertex_memory + primitive_ranges[i].vertex_offset);
+          std::ranges::copy(indices,
+                            index_memory + primitive_ranges[i].first_index);
         }
-        textures.push_back(texture);
-      }
+      });
+  device.unmapMemory(staged.vertices.buffer_memory);
+  device.unmapMemory(staged.indices.buffer_memory);
+  return staged;
+}
+
+void GltfMesh::record_geometry_copy(vk::CommandBuffer upload_command_buffer,
+                                    const StagedGeometry &staged) {
+  vertex_buffer = record_device_local_copy(
+      physical_device, device, upload_command_buffer,
+      vk::BufferUsageFlagBits::eVertexBuffer, staged.vertices,
+      staged.vertex_bytes);
+  index_buffer = record_device_local_copy(
+      physical_device, device, upload_command_buffer,
+      vk::BufferUsageFlagBits::eIndexBuffer, staged.indices,
+      staged.index_bytes);
+}
+
+// Every image a primitive uses gets its texture up front, so the images
+// can be decoded as independent jobs. Images already loaded (by the OBJ
+// materials or another glTF mesh) are shared through the cache, this mesh
+// only loads the ones it created.
+void GltfMesh::acquire_textures() {
+  ice_image::TextureCache &shared_textures =
+      texture_cache != nullptr ? *texture_cache : local_textures;
+  image_textures.assign(model.images.size(), {});
+  for (const GltfPrimitiveData &data : primitives) {
+    if (data.image < 0 || image_textures[data.image].texture != nullptr) {
+      continue;
+    }
+    const tinygltf::Image &gltf_image = model.images[data.image];
+    if (!gltf_image.image.empty()) {
+      // embedded, usually still encoded (see ice::load_gltf_model)
+      image_textures[data.image] =
+          shared_textures.acquire(ice_image::TextureCache::content_key(
+              gltf_image.image, gltf_image.width, gltf_image.height,
+              gltf_image.component));
+    } else if (!gltf_image.uri.empty()) {
+      image_textures[data.image] =
+          shared_textures.acquire(ice_image::TextureCache::file_key(
+              make_path_relative_to_gltf(gltf_filepath, gltf_image.uri)));
     }
   }
 }
 
+ice_image::TextureCreationInput GltfMesh::texture_input() const {
+  return {.physical_device = physical_device,
+          .logical_device = device,
+          .command_buffer = command_buffer,
+          .queue = queue,
+          .layout = descriptor_set_layout,
+          .descriptor_pool = descriptor_pool,
+          .filenames = {},
+          .staging = texture_staging};
+}
+
+void GltfMesh::decode_image(std::size_t index) {
+  const ice_image::TextureCache::Entry &entry = image_textures[index];
+  if (!entry.created) {
+    return;
+  }
+  const tinygltf::Image &gltf_image = model.images[index];
+  ice_image::TextureCreationInput input = texture_input();
+  if (!gltf_image.image.empty()) {
+    // decoded (or expanded to RGBA) once, on the way to the staging buffer
+    entry.texture->decode(input, &gltf_image);
+  } else {
+    // External image file
+    input.filenames.emplace_back(
+        make_path_relative_to_gltf(gltf_filepath, gltf_image.uri));
+#ifndef NDEBUG
+    std::cout << "\nFILENAME\n " << input.filenames[0] << "\n\n";
+#endif
+    entry.texture->decode(input);
+  }
+}
+
+// Uploads the decoded images, then gives every uploaded primitive its
+// texture (or nullptr), aligned with primitive_ranges. The CPU copies of
+// the geometry and the images are no longer needed afterwards.
+void GltfMesh::upload_textures(vk::CommandBuffer upload_command_buffer,
+                               vk::Queue upload_queue) {
+  for (std::size_t i = 0; i < image_textures.size(); ++i) {
+    ice_image::TextureCache::Entry &entry = image_textures[i];
+    if (!entry.created) {
+      continue;
+    }
+    entry.texture->upload(upload_command_buffer, upload_queue);
+    entry.texture->make_descriptor_set();
+    entry.created = false;  // loaded
+    std::vector<unsigned char>().swap(model.images[i].image);
+  }
+
+  textures.clear();
+  for (GltfPrimitiveData &data : primitives) {
+    if (data.vertex_data().empty()) {
+      continue;
+    }
+    data.vertices = {};
+    data.indices = {};
+    textures.push_back(data.image >= 0 ? image_textures[data.image].texture
+                                       : nullptr);
+  }
+}
+
 #ifndef NDEBUG
 void GltfMesh::debug_model() {
   for (auto &mesh : model.meshes) {
@@ -506,14 +1060,10 @@ void GltfMesh::debug_model() {
 }
 #endif
 
+// geometry is in mesh space and stays on the GPU, only the instances move
 void GltfMesh::update_transforms(glm::mat4 new_transform) {
   pre_transform = new_transform;
-
-  mesh_buffers.clear();
-  index_counts.clear();
-
-  // Rebind all models with potentially updated transforms
-  bind_models();
+  collect_instances();
 }
 
 }  // namespace ice
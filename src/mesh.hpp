@@ -2,9 +2,16 @@
 #define MESH_HPP
 
 #include "data_buffers.hpp"
+#include "flat_hash_map.hpp"
 #include "game_objects.hpp"
 #include "images/ice_texture.hpp"
+#include "images/ice_texture_cache.hpp"
 #include "loaders.hpp"
+#include "mapped_file.hpp"
+#include "multithreading/ice_parallel.hpp"
+#include "multithreading/ice_submission_thread.hpp"
+#include "obj_parsing.hpp"
+#include "staging_allocator.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/type_ptr.hpp>
@@ -87,8 +94,11 @@ class ObjMesh {
   std::vector<uint32_t> indices;
   std::vector<glm::vec3> v, vn;
   std::vector<glm::vec2> vt;
-  std::unordered_map<std::string, uint32_t> history;
-  std::unordered_map<std::string, glm::vec3> color_lookup;
+  // vertex of every (position, texcoord, normal, material) seen so far
+  FlatHashMap<obj::CornerKey, uint32_t, obj::CornerKeyHash> history;
+  // material ids: names from the MTL file to their Kd in material_colors
+  std::unordered_map<std::string, uint32_t> material_lookup;
+  std::vector<glm::vec3> material_colors;
   glm::vec3 brush_color{};
   glm::mat4 pre_transform{};
 
@@ -101,23 +111,90 @@ class ObjMesh {
   ObjMesh(const char *obj_filepath, const char *mtl_filepath,
           glm::mat4 pre_transform);
 
+  // Large files are split into chunks at line breaks, parsed in parallel
+  // with parallel_for on scheduler (if given) and merged in file order. The
+  // result does not depend on the chunking. With caching on (mesh_cache.hpp)
+  // the first load of a mesh maps its .icemesh cache if that is up to date
+  // and writes it otherwise.
   void load(const char *obj_filepath, const char *mtl_filepath,
-            glm::mat4 pre_transform);
+            glm::mat4 pre_transform,
+            ice_threading::Scheduler *scheduler = nullptr);
+
+  // The loaded mesh: vertices and indices, or views into the mapped cache
+  // when load() could skip parsing (the vectors stay empty then).
+  [[nodiscard]] std::span<const Vertex> vertex_data() const;
+  [[nodiscard]] std::span<const uint32_t> index_data() const;
+
+  // Receives the batches of stream()
+  using BatchSink = ice_threading::InlineFunction<void(
+      std::span<const Vertex> vertices, std::span<const uint32_t> indices)>;
+
+  // Bounded memory alternative to load() for meshes too large to hold. The
+  // file is read front to back and each batch of at most batch_bytes (its
+  // vertices, indices and their dedup map) is handed to emit, then dropped.
+  // Vertices are only deduplicated within a batch, indices are offset by
+  // first_vertex. Only the v, vt and vn records stay resident until the end,
+  // faces may reference any earlier one. Nothing is kept afterwards.
+  void stream(const char *obj_filepath, const char *mtl_filepath,
+              glm::mat4 pre_transform, std::size_t batch_bytes,
+              uint32_t first_vertex, BatchSink emit);
+
+  // Number of indices the faces of an OBJ file triangulate to, stream()
+  // emits at most one vertex per index.
+  static std::size_t count_indices(const char *obj_filepath);
 
-  void read_vertex_data(const std::vector<std::string> &words);
+ private:
+  struct Chunk;
+
+  void read_materials(std::string_view text);
+  void parse_chunk(std::string_view text, Chunk &chunk) const;
+  void merge_chunks(std::vector<Chunk> &chunks,
+                    ice_threading::Scheduler *scheduler);
+  // the vertex of a globalized corner
+  [[nodiscard]] Vertex make_vertex(const obj::CornerKey &corner) const;
 
-  void read_texcoord_data(const std::vector<std::string> &words);
+  // colors faces before the first usemtl: the last Kd of the MTL file
+  uint32_t default_material{0};
 
-  void read_normal_data(const std::vector<std::string> &words);
+  MappedFile cache;
+  std::span<const Vertex> cached_vertices;
+  std::span<const uint32_t> cached_indices;
+};
 
-  void read_face_data(const std::vector<std::string> &words);
+// Where the geometry of one glTF primitive lives in the shared vertex and
+// index buffers of its GltfMesh, indices are relative to vertex_offset
+struct GltfPrimitiveRange {
+  uint32_t first_index{0};
+  int32_t vertex_offset{0};
+};
 
-  void read_corner(const std::string &vertex_description);
+// The nodes that reference one glTF mesh: a range of
+// GltfMesh::instance_transforms, drawn as instances of its primitives
+struct GltfInstances {
+  uint32_t first{0};
+  uint32_t count{0};
 };
 
-struct MeshBuffer {
-  ice::BufferBundle vertex_buffer;
-  ice::BufferBundle index_buffer;
+// CPU side data of one primitive of a glTF mesh, decoded in mesh space
+// before it is uploaded (once, however many nodes use the mesh)
+struct GltfPrimitiveData {
+  const tinygltf::Primitive *primitive{nullptr};
+  GltfInstances instances;
+  int image{-1};  // of the base color texture, -1 if there is none
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  // views into the mapped .icemesh cache instead, when decoding was skipped
+  std::span<const Vertex> cached_vertices;
+  std::span<const uint32_t> cached_indices;
+
+  [[nodiscard]] std::span<const Vertex> vertex_data() const {
+    return cached_vertices.empty() ? std::span<const Vertex>(vertices)
+                                   : cached_vertices;
+  }
+  [[nodiscard]] std::span<const uint32_t> index_data() const {
+    return cached_indices.empty() ? std::span<const uint32_t>(indices)
+                                  : cached_indices;
+  }
 };
 
 // loads mesh data from GLTF, it can represent a whole scene
@@ -132,23 +209,96 @@ class GltfMesh {
            vk::DescriptorPool descriptor_pool, const char *gltf_filepath,
            glm::mat4 pre_transform);
 
-  // new transform to update the mesh with
+  // Stores the handles without loading, for staged loading through jobs:
+  // parse(), then decode_primitive() for every primitive and decode_image()
+  // for every image, then upload().
+  // Large primitives are decoded with parallel_for on scheduler, if given.
+  // Textures are shared through texture_cache (with the OBJ materials), if
+  // given, otherwise only between the primitives of this mesh. Their pixels
+  // are staged in texture_staging, if given.
+  GltfMesh(vk::PhysicalDevice physical_device, vk::Device device,
+           vk::CommandBuffer command_buffer, vk::Queue queue,
+           vk::DescriptorSetLayout descriptor_set_layout,
+           vk::DescriptorPool descriptor_pool, glm::mat4 pre_transform,
+           ice_threading::Scheduler *scheduler = nullptr,
+           ice_image::TextureCache *texture_cache = nullptr,
+           ice::StagingAllocator *texture_staging = nullptr);
+
+  // Reads the file and collects the primitives of the default scene. Their
+  // vertex and index data come from the .icemesh cache if caching is on and
+  // it is up to date, decode_primitive() then has nothing left to do.
+  void parse(const char *gltf_filepath);
+
+  [[nodiscard]] std::size_t primitive_count() const {
+    return primitives.size();
+  }
+
+  // Decodes vertex and index data of one primitive. Primitives are
+  // independent, so they may be decoded concurrently.
+  void decode_primitive(std::size_t index);
+
+  [[nodiscard]] std::size_t image_count() const {
+    return image_textures.size();
+  }
+
+  // Decodes one image of the model, unless its texture is shared with an
+  // already loaded one. Images may be decoded concurrently.
+  void decode_image(std::size_t index);
+
+  // Creates the GPU buffers of every decoded primitive and the textures of
+  // the decoded images.
+  void upload(vk::CommandBuffer upload_command_buffer, vk::Queue upload_queue);
+
+  // upload() as a coroutine: the buffer copies of all primitives are in
+  // flight together and no thread waits for them. Needs the scheduler.
+  ice_threading::Task<> upload_async(
+      ice_threading::SubmissionThread &submission);
+
+  // Replaces pre_transform. Only instance_transforms are recomputed, the
+  // renderer copies them to the GPU on the next frames.
   void update_transforms(glm::mat4 new_transform);
 
-  std::vector<Vertex> vertices;
-  std::vector<uint32_t> indices;
+  // changes whenever instance_transforms do
+  [[nodiscard]] uint64_t transforms_version() const {
+    return transform_version;
+  }
 
-  std::vector<MeshBuffer> mesh_buffers;
+  // geometry of every uploaded primitive, packed like the MeshCollator
+  // lumps so all of them draw with a single binding
+  BufferBundle vertex_buffer, index_buffer;
+  std::vector<GltfPrimitiveRange> primitive_ranges;
   std::vector<uint32_t> index_counts;
+  // which instance_transforms each of primitive_ranges is drawn with
+  std::vector<GltfInstances> primitive_instances;
+
+  // global transforms (pre_transform included) of the nodes, grouped by mesh
+  std::vector<InstanceTransform> instance_transforms;
 
-  std::vector<ice_image::Texture *> textures;
+  std::vector<std::shared_ptr<ice_image::Texture>> textures;
 
  private:
   void load(const char *gltf_filepath);
-  void bind_models();
-  void bind_model_nodes(tinygltf::Node &node,
-                        glm::mat4 parent_transform = glm::mat4(1.0f));
-  void bind_mesh(tinygltf::Mesh &mesh, const glm::mat4 &global_transform);
+  void collect_primitives();
+  std::vector<GltfInstances> collect_instances();
+  [[nodiscard]] std::vector<std::string> cache_sources() const;
+  void map_cache();
+  void write_cache() const;
+  void release_cache();
+  void collect_node_transforms(
+      const tinygltf::Node &node, glm::mat4 parent_transform,
+      std::vector<std::vector<glm::mat4>> &mesh_transforms) const;
+  // host visible copies of all the primitives' geometry, packed
+  struct StagedGeometry {
+    BufferBundle vertices, indices;
+    vk::DeviceSize vertex_bytes{0}, index_bytes{0};
+  };
+  StagedGeometry stage_geometry();
+  void record_geometry_copy(vk::CommandBuffer upload_command_buffer,
+                            const StagedGeometry &staged);
+  void upload_textures(vk::CommandBuffer upload_command_buffer,
+                       vk::Queue upload_queue);
+  void acquire_textures();
+  [[nodiscard]] ice_image::TextureCreationInput texture_input() const;
   static glm::mat4 get_local_transform(const tinygltf::Node &node);
 
 #ifndef NDEBUG
@@ -156,9 +306,18 @@ class GltfMesh {
 #endif
 
   tinygltf::Model model;
+  std::vector<GltfPrimitiveData> primitives;
 
   glm::mat4 pre_transform{};
+  uint64_t transform_version{0};
   std::string gltf_filepath;
+  ice_threading::Scheduler *scheduler{nullptr};
+  ice_image::TextureCache *texture_cache{nullptr};
+  ice_image::TextureCache local_textures;
+  StagingAllocator *texture_staging{nullptr};
+  // by image, only the created ones are decoded and uploaded by this mesh
+  std::vector<ice_image::TextureCache::Entry> image_textures;
+  MappedFile cache;  // holds the data of the primitives on a warm start
 
   vk::PhysicalDevice physical_device;
   vk::Device device;
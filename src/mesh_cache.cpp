@@ -0,0 +1,238 @@
+#include "mesh_cache.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+namespace ice {
+
+namespace {
+constexpr std::array<char, 8> MAGIC = {'I', 'C', 'E', 'M', 'E', 'S', 'H', '\0'};
+// bump whenever the layout below, Vertex or the decoded data changes
+// (2: stride-aware glTF accessors, 3: glTF primitives in mesh space)
+constexpr uint32_t VERSION = 3;
+// of every part's data in the file
+constexpr std::size_t DATA_ALIGNMENT = 16;
+
+struct Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t vertex_size;
+  uint64_t source_key;
+  std::array<float, 16> pre_transform;
+  uint64_t part_count;
+};
+
+// followed by part_count of these, offsets are from the start of the file
+struct PartEntry {
+  uint64_t vertex_offset;
+  uint64_t vertex_count;
+  uint64_t index_offset;
+  uint64_t index_count;
+};
+
+std::size_t align_up(std::size_t offset) {
+  return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+// FNV-1a over the path, size and modification time of every source, nullopt
+// if one is missing
+std::optional<uint64_t> make_source_key(std::span<const std::string> sources) {
+  uint64_t hash = 14695981039346656037ULL;
+  const auto mix = [&hash](const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+  };
+
+  for (const std::string &source : sources) {
+    std::error_code error;
+    const uint64_t size = std::filesystem::file_size(source, error);
+    if (error) {
+      return std::nullopt;
+    }
+    const int64_t modified =
+        std::filesystem::last_write_time(source, error)
+            .time_since_epoch()
+            .count();
+    if (error) {
+      return std::nullopt;
+    }
+    // the terminator separates consecutive paths
+    mix(source.c_str(), source.size() + 1);
+    mix(&size, sizeof(size));
+    mix(&modified, sizeof(modified));
+  }
+  return hash;
+}
+
+std::array<float, 16> flatten(const glm::mat4 &matrix) {
+  std::array<float, 16> values{};
+  std::memcpy(values.data(), &matrix, sizeof(values));
+  return values;
+}
+
+std::optional<std::filesystem::path> &cache_directory() {
+  static std::optional<std::filesystem::path> directory =
+      []() -> std::optional<std::filesystem::path> {
+    const char *setting = std::getenv("ICE_MESH_CACHE_DIR");
+    if (setting == nullptr || *setting == '\0') {
+      return std::nullopt;
+    }
+    return setting;
+  }();
+  return directory;
+}
+}  // namespace
+
+void set_mesh_cache_directory(
+    std::optional<std::filesystem::path> directory) {
+  cache_directory() = std::move(directory);
+}
+
+std::optional<std::string> mesh_cache_path(const std::string &source) {
+  const std::optional<std::filesystem::path> &directory = cache_directory();
+  if (!directory) {
+    return std::nullopt;
+  }
+  // the hash of the full path tells apart sources of the same name
+  std::error_code error;
+  const std::filesystem::path absolute =
+      std::filesystem::absolute(source, error);
+  const std::string full_path = error ? source : absolute.string();
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : full_path) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return (*directory /
+          std::format("{}-{:016x}.icemesh",
+                      std::filesystem::path(source).filename().string(),
+                      hash))
+      .string();
+}
+
+std::optional<std::vector<MeshCachePart>> read_mesh_cache(
+    const MappedFile &cache, std::span<const std::string> sources,
+    const glm::mat4 &pre_transform) {
+  const std::string_view file = cache.view();
+  if (file.size() < sizeof(Header)) {
+    return std::nullopt;
+  }
+
+  Header header{};
+  std::memcpy(&header, file.data(), sizeof(header));
+  const std::optional<uint64_t> source_key = make_source_key(sources);
+  // the matrix is compared bitwise, any change rebuilds the cache
+  if (header.magic != MAGIC || header.version != VERSION ||
+      header.vertex_size != sizeof(Vertex) || !source_key ||
+      header.source_key != *source_key ||
+      header.pre_transform != flatten(pre_transform) ||
+      header.part_count >
+          (file.size() - sizeof(Header)) / sizeof(PartEntry)) {
+    return std::nullopt;
+  }
+
+  std::vector<MeshCachePart> parts(header.part_count);
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    PartEntry entry{};
+    std::memcpy(&entry, file.data() + sizeof(Header) + i * sizeof(PartEntry),
+                sizeof(entry));
+    // rejects truncated files, the counts are bounded by the file size first
+    // so the products cannot overflow
+    if (entry.vertex_offset > file.size() || entry.index_offset > file.size() ||
+        entry.vertex_count > file.size() / sizeof(Vertex) ||
+        entry.index_count > file.size() / sizeof(uint32_t) ||
+        entry.vertex_count * sizeof(Vertex) >
+            file.size() - entry.vertex_offset ||
+        entry.index_count * sizeof(uint32_t) >
+            file.size() - entry.index_offset) {
+      return std::nullopt;
+    }
+    // the mapping is page aligned and the data offsets are aligned
+    parts[i].vertices = {
+        reinterpret_cast<const Vertex *>(file.data() + entry.vertex_offset),
+        entry.vertex_count};
+    parts[i].indices = {
+        reinterpret_cast<const uint32_t *>(file.data() + entry.index_offset),
+        entry.index_count};
+  }
+  return parts;
+}
+
+bool write_mesh_cache(std::span<const std::string> sources,
+                      const glm::mat4 &pre_transform,
+                      std::span<const MeshCachePart> parts) {
+  if (sources.empty()) {
+    return false;
+  }
+  const std::optional<std::string> cache_path =
+      mesh_cache_path(sources.front());
+  const std::optional<uint64_t> source_key =
+      cache_path ? make_source_key(sources) : std::nullopt;
+  if (!source_key) {
+    return false;
+  }
+
+  const Header header{.magic = MAGIC,
+                      .version = VERSION,
+                      .vertex_size = sizeof(Vertex),
+                      .source_key = *source_key,
+                      .pre_transform = flatten(pre_transform),
+                      .part_count = parts.size()};
+
+  std::vector<PartEntry> entries(parts.size());
+  std::size_t offset = sizeof(Header) + parts.size() * sizeof(PartEntry);
+  for (std::size_t i = 0; i < parts.size(); ++i) {
+    entries[i].vertex_offset = offset = align_up(offset);
+    entries[i].vertex_count = parts[i].vertices.size();
+    offset += parts[i].vertices.size_bytes();
+    entries[i].index_offset = offset = align_up(offset);
+    entries[i].index_count = parts[i].indices.size();
+    offset += parts[i].indices.size_bytes();
+  }
+
+  // written aside and renamed, so a crash never leaves a torn cache behind
+  const std::string &path = *cache_path;
+  const std::string temporary_path = path + ".tmp";
+  std::error_code error;
+  std::filesystem::create_directories(
+      std::filesystem::path(path).parent_path(), error);
+  if (error) {
+    return false;
+  }
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    const auto pad_to = [&file](std::size_t position) {
+      constexpr std::array<char, DATA_ALIGNMENT> ZEROS{};
+      const auto current = static_cast<std::size_t>(file.tellp());
+      file.write(ZEROS.data(),
+                 static_cast<std::streamsize>(position - current));
+    };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(entries.data()),
+               static_cast<std::streamsize>(entries.size() *
+                                            sizeof(PartEntry)));
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+      pad_to(entries[i].vertex_offset);
+      file.write(reinterpret_cast<const char *>(parts[i].vertices.data()),
+                 static_cast<std::streamsize>(parts[i].vertices.size_bytes()));
+      pad_to(entries[i].index_offset);
+      file.write(reinterpret_cast<const char *>(parts[i].indices.data()),
+                 static_cast<std::streamsize>(parts[i].indices.size_bytes()));
+    }
+    if (!file) {
+      file.close();
+      std::filesystem::remove(temporary_path, error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(temporary_path, path, error);
+  return !error;
+}
+}  // namespace ice
@@ -0,0 +1,53 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+
+namespace ice {
+
+/**
+ * Binary cache of the final vertex and index data of a mesh (.icemesh), so a
+ * warm start maps it instead of parsing text. Caching is off unless a cache
+ * directory is set (ICE_MESH_CACHE_DIR or set_mesh_cache_directory()), the
+ * asset tree is never written to. The cache of a mesh is named after its
+ * first source file and only matches while every source still has the path,
+ * size and modification time it was written with, and the mesh is loaded
+ * with the same pre_transform. A mesh is stored as parts: the whole OBJ
+ * file, or one part per glTF primitive.
+ */
+struct MeshCachePart {
+  std::span<const Vertex> vertices;
+  std::span<const uint32_t> indices;
+};
+
+// Overrides ICE_MESH_CACHE_DIR, nullopt turns caching off. Call it before
+// any mesh is loaded.
+void set_mesh_cache_directory(std::optional<std::filesystem::path> directory);
+
+// Where the cache of a mesh whose first source is source lives, nullopt
+// while caching is off
+std::optional<std::string> mesh_cache_path(const std::string &source);
+
+// The parts stored in cache, a mapped .icemesh file. They point into the
+// mapping. Empty if the file is missing, truncated, of another format version
+// or stale for sources and pre_transform.
+std::optional<std::vector<MeshCachePart>> read_mesh_cache(
+    const MappedFile &cache, std::span<const std::string> sources,
+    const glm::mat4 &pre_transform);
+
+// Writes the cache of sources, replacing the old one only once complete and
+// creating the cache directory if needed. Returns false if caching is off, a
+// source is missing or the file could not be written (the next load misses).
+bool write_mesh_cache(std::span<const std::string> sources,
+                      const glm::mat4 &pre_transform,
+                      std::span<const MeshCachePart> parts);
+}  // namespace ice
+
+#endif  // MESH_CACHE_HPP
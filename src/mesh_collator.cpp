@@ -1,5 +1,7 @@
 #include "mesh_collator.hpp"
 
+#include "staging_ring.hpp"
+
 namespace ice {
 
 #ifndef NDEBUG
@@ -16,12 +18,12 @@ std::string to_string(MeshTypes type) {
 }
 #endif
 
-void MeshCollator::consume(MeshTypes type,
-                           const std::vector<Vertex> &vertex_data,
-                           const std::vector<std::uint32_t> &index_data) {
-  vertex_lump.reserve(vertex_data.size());
-  index_lump.reserve(index_data.size());
+MeshCollator::MeshCollator(ice_threading::Scheduler *scheduler)
+    : scheduler(scheduler) {}
 
+void MeshCollator::consume(MeshTypes type,
+                           std::span<const Vertex> vertex_data,
+                           std::span<const std::uint32_t> index_data) {
   auto vertex_count = static_cast<std::uint32_t>(vertex_data.size());
 
   index_lump_offsets.insert(
@@ -37,12 +39,19 @@ void MeshCollator::consume(MeshTypes type,
       static_cast<int>(index_data.size()));
 #endif
 
-  for (const Vertex &attribute : vertex_data) {
-    vertex_lump.push_back(attribute);
-  }
-  for (const std::uint32_t index : index_data) {
-    index_lump.push_back(index_offset + index);
-  }
+  vertex_lump.insert(vertex_lump.end(), vertex_data.begin(),
+                     vertex_data.end());
+
+  // rebase the indices onto the lump
+  const std::size_t index_base = index_lump.size();
+  index_lump.resize(index_base + index_data.size());
+  ice_threading::parallel_for(
+      scheduler, 0, index_data.size(), 16384,
+      [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+          index_lump[index_base + i] = index_offset + index_data[i];
+        }
+      });
 
   index_offset += vertex_count;
 }
@@ -65,6 +74,142 @@ void MeshCollator::finalize(
   index_lump.clear();
 }
 
+// Copies the first used bytes of vertices into a new device local vertex
+// buffer of capacity bytes and destroys the old one (destroying the null
+// handles of an empty bundle is a no-op, which only allocates)
+static BufferBundle move_vertices(
+    const VertexBufferStreamingInput &streaming_input,
+    const BufferBundle &vertices, vk::DeviceSize used,
+    vk::DeviceSize capacity) {
+  const BufferBundle moved = create_buffer(
+      {.size = capacity,
+       .usage = vk::BufferUsageFlagBits::eTransferDst |
+                vk::BufferUsageFlagBits::eTransferSrc |
+                vk::BufferUsageFlagBits::eVertexBuffer,
+       .memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+       .logical_device = streaming_input.logical_device,
+       .physical_device = streaming_input.physical_device});
+  if (used > 0) {
+    const ice_threading::SubmissionThread::TransientCommands commands =
+        streaming_input.submission->make_transient_commands();
+    commands.command_buffer.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    const vk::BufferCopy copy_region{
+        .srcOffset = 0, .dstOffset = 0, .size = used};
+    commands.command_buffer.copyBuffer(vertices.buffer, moved.buffer, 1,
+                                       &copy_region);
+    commands.command_buffer.end();
+    if (streaming_input.submission->submit_and_wait(
+            commands.command_buffer) != vk::Result::eSuccess) {
+#ifndef NDEBUG
+      std::cerr << "Vertex buffer move copy failed!\n";
+#endif
+    }
+    streaming_input.logical_device.destroyCommandPool(commands.command_pool);
+  }
+  destroy_buffer(streaming_input.logical_device, vertices);
+  return moved;
+}
+
+void MeshCollator::stream(const VertexBufferStreamingInput &streaming_input,
+                          std::span<const ObjStreamSource> sources) {
+  // half of the budget parses, the other half is in flight to the GPU
+  const std::size_t batch_bytes = streaming_input.memory_budget / 2;
+  const std::size_t slot_bytes = std::max<std::size_t>(
+      batch_bytes / STREAMING_STAGING_SLOTS, MIN_STREAMING_SLOT_BYTES);
+  logical_device = streaming_input.logical_device;
+
+  std::size_t index_total = 0;
+  for (const ObjStreamSource &source : sources) {
+    index_total += ObjMesh::count_indices(source.obj_filepath);
+  }
+  if (index_total == 0) {
+    return;
+  }
+
+  // The index buffer is sized exactly. The vertex buffer starts at a quarter
+  // of the worst case of no corner being shared (index_total vertices) and
+  // doubles when a batch does not fit, then shrinks to the real count.
+  const vk::DeviceSize max_vertex_bytes = index_total * sizeof(Vertex);
+  vk::DeviceSize vertex_capacity =
+      std::max<vk::DeviceSize>(max_vertex_bytes / 4, sizeof(Vertex));
+  BufferBundle streamed_vertices =
+      move_vertices(streaming_input, {}, 0, vertex_capacity);
+  index_buffer = create_buffer(
+      {.size = index_total * sizeof(std::uint32_t),
+       .usage = vk::BufferUsageFlagBits::eTransferDst |
+                vk::BufferUsageFlagBits::eIndexBuffer,
+       .memory_properties = vk::MemoryPropertyFlagBits::eDeviceLocal,
+       .logical_device = streaming_input.logical_device,
+       .physical_device = streaming_input.physical_device});
+
+  StagingRing ring({.physical_device = streaming_input.physical_device,
+                    .logical_device = streaming_input.logical_device,
+                    .submission = streaming_input.submission,
+                    .slot_size = slot_bytes,
+                    .slot_count = STREAMING_STAGING_SLOTS});
+  vk::DeviceSize vertex_bytes = 0;
+  std::size_t streamed_indices = 0;
+
+  for (const ObjStreamSource &source : sources) {
+    const std::uint32_t first_vertex = index_offset;
+    const std::size_t first_index = streamed_indices;
+
+    ObjMesh mesh;
+    mesh.stream(
+        source.obj_filepath, source.mtl_filepath, source.pre_transform,
+        batch_bytes, first_vertex,
+        [&](std::span<const Vertex> vertices,
+            std::span<const std::uint32_t> indices) {
+          if (vertex_bytes + vertices.size_bytes() > vertex_capacity) {
+            // the copies into the old buffer have to land before it moves
+            ring.wait_idle();
+            vertex_capacity = std::min(
+                max_vertex_bytes,
+                std::max(vertex_capacity * 2,
+                         vertex_bytes + vertices.size_bytes()));
+            streamed_vertices = move_vertices(
+                streaming_input, streamed_vertices, vertex_bytes,
+                vertex_capacity);
+          }
+          ring.upload(std::as_bytes(vertices), streamed_vertices.buffer,
+                      vertex_bytes);
+          ring.upload(std::as_bytes(indices), index_buffer.buffer,
+                      streamed_indices * sizeof(std::uint32_t));
+          vertex_bytes += vertices.size_bytes();
+          streamed_indices += indices.size();
+          index_offset += static_cast<std::uint32_t>(vertices.size());
+        });
+
+    index_lump_offsets.insert(
+        std::make_pair(source.type, static_cast<int>(first_index)));
+    index_counts.insert(std::make_pair(
+        source.type, static_cast<int>(streamed_indices - first_index)));
+
+#ifndef NDEBUG
+    std::cout << std::format(
+        "\nMesh Type:        {:<8}, Vertex Count:  {} (streamed)"
+        "\nIndex count :     {}\n\n",
+        ice::to_string(source.type), index_offset - first_vertex,
+        streamed_indices - first_index);
+#endif
+  }
+
+  if (!ring.wait_idle()) {
+#ifndef NDEBUG
+    std::cerr << "Streaming the meshes to the GPU failed!\n";
+#endif
+  }
+
+  // move the vertices into a buffer of their real size, on the GPU
+  if (vertex_bytes == vertex_capacity) {
+    vertex_buffer = streamed_vertices;
+    return;
+  }
+  vertex_buffer = move_vertices(streaming_input, streamed_vertices,
+                                vertex_bytes, vertex_bytes);
+}
+
 MeshCollator::~MeshCollator() {
   logical_device.destroyBuffer(vertex_buffer.buffer);
   logical_device.freeMemory(vertex_buffer.buffer_memory);
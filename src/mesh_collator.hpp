@@ -5,6 +5,7 @@
 #include "data_buffers.hpp"
 #include "game_objects.hpp"
 #include "mesh.hpp"
+#include "multithreading/ice_parallel.hpp"
 
 namespace ice {
 
@@ -15,25 +16,60 @@ struct VertexBufferFinalizationInput {
   vk::Queue queue;
 };
 
+// the staging ring MeshCollator::stream uploads the batches through
+inline constexpr std::size_t STREAMING_STAGING_SLOTS = 4;
+inline constexpr std::size_t MIN_STREAMING_SLOT_BYTES = 64 * 1024;
+// half of the budget is the staging ring, below this its slots would
+// outgrow it
+inline constexpr std::size_t MIN_STREAMING_BUDGET =
+    2 * STREAMING_STAGING_SLOTS * MIN_STREAMING_SLOT_BYTES;
+
+struct VertexBufferStreamingInput {
+  vk::Device logical_device;
+  vk::PhysicalDevice physical_device;
+  ice_threading::SubmissionThread *submission;
+  // host memory for the batches being parsed and the staging ring together,
+  // at least MIN_STREAMING_BUDGET
+  std::size_t memory_budget;
+};
+
+// An OBJ mesh for MeshCollator::stream
+struct ObjStreamSource {
+  MeshTypes type;
+  const char *obj_filepath;
+  const char *mtl_filepath;
+  glm::mat4 pre_transform;
+};
+
 // Collates multiple meshes and lump them into one vertex buffer (allocates it)
 // stores useful attributes information of these meshes like offsets, vertex
 // count etc.
 class MeshCollator {
  public:
   MeshCollator() = default;
+  // large index lumps are offset with parallel_for on scheduler
+  explicit MeshCollator(ice_threading::Scheduler *scheduler);
   ~MeshCollator();
   // takes in various MeshTypes and adds data concatenate Vertex and indices
   // data
-  void consume(MeshTypes type, const std::vector<Vertex> &vertex_data,
-               const std::vector<std::uint32_t> &index_data);
+  void consume(MeshTypes type, std::span<const Vertex> vertex_data,
+               std::span<const std::uint32_t> index_data);
   // populates vertex and index BufferBundles
   void finalize(const VertexBufferFinalizationInput &finalization_chunk);
+  // Replaces consume() and finalize() for meshes too large to hold in host
+  // memory: the OBJ files are parsed in batches (ObjMesh::stream) that go
+  // straight to the device local buffers through a staging ring. The batches
+  // and the ring stay within the budget, but the v, vt and vn records of the
+  // mesh being parsed are still held whole (faces may reference any of them).
+  void stream(const VertexBufferStreamingInput &streaming_input,
+              std::span<const ObjStreamSource> sources);
   BufferBundle vertex_buffer, index_buffer;
   std::unordered_map<MeshTypes, std::uint32_t> index_lump_offsets;
   std::unordered_map<MeshTypes, std::uint32_t> index_counts;
 
  private:
   std::uint32_t index_offset{0};
+  ice_threading::Scheduler *scheduler{nullptr};
   vk::Device logical_device;
   std::vector<Vertex> vertex_lump;
   std::vector<std::uint32_t> index_lump;
@@ -0,0 +1,16 @@
+#include "ice_frame_phase.hpp"
+
+namespace ice_threading {
+
+FramePhase::FramePhase(Scheduler &scheduler) : scheduler(scheduler) {}
+
+FramePhase::~FramePhase() { wait(); }
+
+void FramePhase::submit(Job *job) {
+  // the frame is waiting on it
+  job->priority = JobPriority::HIGH;
+  scheduler.submit(job, &counter);
+}
+
+void FramePhase::wait() { scheduler.wait(counter); }
+}  // namespace ice_threading
@@ -0,0 +1,32 @@
+#ifndef ICE_FRAME_PHASE_HPP
+#define ICE_FRAME_PHASE_HPP
+
+#include "ice_scheduler.hpp"
+
+namespace ice_threading {
+
+/**
+ * A batch of per-frame jobs, e.g. transform updates while the main thread
+ * records commands. Jobs submitted to a phase run on the persistent workers,
+ * wait() returns once all of them completed and lets the calling thread help
+ * in the meantime. A phase waits on destruction, so its jobs never outlive
+ * the frame data they work on. Phase jobs run at HIGH priority.
+ */
+class FramePhase {
+ public:
+  explicit FramePhase(Scheduler &scheduler);
+  ~FramePhase();
+
+  FramePhase(const FramePhase &) = delete;
+  FramePhase &operator=(const FramePhase &) = delete;
+
+  void submit(Job *job);
+  void wait();
+
+ private:
+  Scheduler &scheduler;
+  JobCounter counter;
+};
+}  // namespace ice_threading
+
+#endif  // ICE_FRAME_PHASE_HPP
@@ -0,0 +1,97 @@
+#ifndef ICE_INLINE_FUNCTION_HPP
+#define ICE_INLINE_FUNCTION_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ice_threading {
+
+template <typename Signature, std::size_t Capacity = 64>
+class InlineFunction;
+
+/**
+ * Move-only type-erased callable whose target lives inside the object, so
+ * wrapping a lambda never allocates (std::function only does so for tiny
+ * captures). Targets larger than Capacity are rejected at compile time:
+ * capture by reference or pointer instead.
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+ public:
+  InlineFunction() = default;
+
+  template <typename F, typename = std::enable_if_t<
+                            !std::is_same_v<std::decay_t<F>, InlineFunction>>>
+  InlineFunction(F &&function) {  // NOLINT(google-explicit-constructor)
+    using Target = std::decay_t<F>;
+    static_assert(sizeof(Target) <= Capacity,
+                  "captures do not fit inline, capture by reference instead");
+    static_assert(alignof(Target) <= alignof(std::max_align_t),
+                  "over-aligned captures are not supported");
+    static_assert(std::is_nothrow_move_constructible_v<Target>,
+                  "captures must be nothrow movable");
+
+    new (storage) Target(std::forward<F>(function));
+    invoke = [](void *target, Args... args) -> R {
+      return (*static_cast<Target *>(target))(std::forward<Args>(args)...);
+    };
+    relocate = [](void *destination, void *source) {
+      auto *target = static_cast<Target *>(source);
+      if (destination != nullptr) {
+        new (destination) Target(std::move(*target));
+      }
+      target->~Target();
+    };
+  }
+
+  InlineFunction(InlineFunction &&other) noexcept { take(other); }
+
+  InlineFunction &operator=(InlineFunction &&other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  InlineFunction(const InlineFunction &) = delete;
+  InlineFunction &operator=(const InlineFunction &) = delete;
+
+  ~InlineFunction() { reset(); }
+
+  R operator()(Args... args) {
+    return invoke(storage, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const { return invoke != nullptr; }
+
+ private:
+  void take(InlineFunction &other) noexcept {
+    if (other.invoke == nullptr) {
+      return;
+    }
+    other.relocate(storage, other.storage);
+    invoke = other.invoke;
+    relocate = other.relocate;
+    other.invoke = nullptr;
+    other.relocate = nullptr;
+  }
+
+  void reset() noexcept {
+    if (relocate != nullptr) {
+      relocate(nullptr, storage);
+    }
+    invoke = nullptr;
+    relocate = nullptr;
+  }
+
+  alignas(std::max_align_t) std::byte storage[Capacity];
+  R (*invoke)(void *, Args...) = nullptr;
+  // moves the target into destination (if not null) and destroys the source
+  void (*relocate)(void *destination, void *source) = nullptr;
+};
+}  // namespace ice_threading
+
+#endif  // ICE_INLINE_FUNCTION_HPP
@@ -0,0 +1,70 @@
+#include "ice_io_thread.hpp"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+
+namespace ice_threading {
+
+namespace {
+// contents is left empty on failure
+void read_whole_file(const std::string &path,
+                     std::vector<unsigned char> &contents) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+#ifndef NDEBUG
+    std::cerr << std::format("Unable to open {}\n", path);
+#endif
+    return;
+  }
+
+  const std::streamsize size = file.tellg();
+  file.seekg(0);
+  contents.resize(static_cast<std::size_t>(size));
+  if (!file.read(reinterpret_cast<char *>(contents.data()), size)) {
+    contents.clear();
+  }
+}
+}  // namespace
+
+IoThread::IoThread()
+    : thread([this](const std::stop_token &stop) { run(stop); }) {}
+
+IoThread::~IoThread() {
+  thread.request_stop();
+  thread.join();
+}
+
+void IoThread::read(std::string path, std::vector<unsigned char> *contents,
+                    Completion on_complete) {
+  {
+    const std::lock_guard<std::mutex> guard(request_lock);
+    requests.push_back({.path = std::move(path),
+                        .contents = contents,
+                        .on_complete = std::move(on_complete)});
+  }
+  pending.notify_one();
+}
+
+void IoThread::run(const std::stop_token &stop) {
+  set_trace_thread_name("io");
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> guard(request_lock);
+      pending.wait(guard, stop, [this] { return !requests.empty(); });
+      if (requests.empty()) {
+        return;  // stop requested, every read was served
+      }
+      request = std::move(requests.front());
+      requests.pop_front();
+    }
+
+    {
+      const TraceScope trace("read file", TraceCategory::IO);
+      read_whole_file(request.path, *request.contents);
+    }
+    request.on_complete();
+  }
+}
+}  // namespace ice_threading
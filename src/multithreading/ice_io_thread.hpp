@@ -0,0 +1,72 @@
+#ifndef ICE_IO_THREAD_HPP
+#define ICE_IO_THREAD_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ice_task.hpp"
+
+namespace ice_threading {
+
+/**
+ * Performs blocking file reads on its own thread, so tasks waiting for a
+ * file do not hold on to a worker.
+ */
+class IoThread {
+ public:
+  using Completion = InlineFunction<void()>;
+
+  IoThread();
+  ~IoThread();
+
+  IoThread(const IoThread &) = delete;
+  IoThread &operator=(const IoThread &) = delete;
+
+  // Reads the whole file into contents (left empty on failure), then calls
+  // on_complete on the I/O thread. contents must stay alive until then.
+  void read(std::string path, std::vector<unsigned char> *contents,
+            Completion on_complete);
+
+ private:
+  struct Request {
+    std::string path;
+    std::vector<unsigned char> *contents;
+    Completion on_complete;
+  };
+
+  void run(const std::stop_token &stop);
+
+  std::deque<Request> requests;
+  std::mutex request_lock;
+  std::condition_variable_any pending;
+
+  std::jthread thread;  // last, starts once everything else is constructed
+};
+
+// co_await read_file(io, scheduler, path): the file's contents, empty if it
+// could not be read. Resumes on the scheduler.
+inline auto read_file(IoThread &io, Scheduler &scheduler, std::string path) {
+  struct Awaiter {
+    IoThread &io;
+    Scheduler &scheduler;
+    std::string path;
+    std::vector<unsigned char> contents;
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      const JobPriority priority = Scheduler::current_priority();
+      io.read(path, &contents, [this, handle, priority] {
+        resume_on(scheduler, handle, priority);
+      });
+    }
+    std::vector<unsigned char> await_resume() { return std::move(contents); }
+  };
+  return Awaiter{io, scheduler, std::move(path), {}};
+}
+}  // namespace ice_threading
+
+#endif  // ICE_IO_THREAD_HPP
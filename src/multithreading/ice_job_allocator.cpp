@@ -0,0 +1,178 @@
+#include "ice_job_allocator.hpp"
+
+#include <array>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ice_threading {
+
+namespace {
+constexpr std::array<std::size_t, 3> BLOCK_SIZES = {128, 256, 512};
+constexpr std::size_t CLASS_COUNT = BLOCK_SIZES.size();
+constexpr std::size_t BLOCKS_PER_SLAB = 64;
+constexpr std::align_val_t SLAB_ALIGNMENT{JOB_BLOCK_ALIGNMENT};
+
+// a thread's list is trimmed back to one slab worth at this length
+constexpr std::size_t SPILL_LENGTH = 2 * BLOCKS_PER_SLAB;
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+// Detaches up to count blocks from the front of list, returns the first
+// (nullptr if list was empty) and the number taken
+std::pair<FreeBlock *, std::size_t> take_blocks(FreeBlock *&list,
+                                                std::size_t count) {
+  FreeBlock *first = list;
+  FreeBlock *last = nullptr;
+  std::size_t taken = 0;
+  for (FreeBlock *block = list; block != nullptr && taken < count;
+       block = block->next) {
+    last = block;
+    ++taken;
+  }
+  if (last != nullptr) {
+    list = last->next;
+    last->next = nullptr;
+  }
+  return {taken != 0 ? first : nullptr, taken};
+}
+
+// Owns every slab, and the free blocks spilled by busy threads or left
+// behind by exited ones
+struct Depot {
+  std::mutex lock;
+  std::array<FreeBlock *, CLASS_COUNT> free_lists{};
+  std::vector<void *> slabs;
+
+  Depot() = default;
+  Depot(const Depot &) = delete;
+  Depot &operator=(const Depot &) = delete;
+
+  ~Depot() {
+    for (void *slab : slabs) {
+      ::operator delete(slab, SLAB_ALIGNMENT);
+    }
+  }
+};
+
+Depot &depot() {
+  static Depot instance;
+  return instance;
+}
+
+struct ThreadCache {
+  std::array<FreeBlock *, CLASS_COUNT> free_lists{};
+  std::array<std::size_t, CLASS_COUNT> lengths{};
+
+  ThreadCache() = default;
+  ThreadCache(const ThreadCache &) = delete;
+  ThreadCache &operator=(const ThreadCache &) = delete;
+
+  ~ThreadCache() {
+    Depot &shared = depot();
+    const std::lock_guard<std::mutex> guard(shared.lock);
+    for (std::size_t i = 0; i < CLASS_COUNT; ++i) {
+      while (free_lists[i] != nullptr) {
+        FreeBlock *block = free_lists[i];
+        free_lists[i] = block->next;
+        block->next = shared.free_lists[i];
+        shared.free_lists[i] = block;
+      }
+    }
+  }
+};
+
+thread_local ThreadCache cache;
+
+std::size_t size_class(std::size_t size) {
+  for (std::size_t i = 0; i < CLASS_COUNT; ++i) {
+    if (size <= BLOCK_SIZES[i]) {
+      return i;
+    }
+  }
+  return CLASS_COUNT;
+}
+
+// Only called when the thread's list for size_index is empty
+void refill(std::size_t size_index) {
+  Depot &shared = depot();
+  const std::lock_guard<std::mutex> guard(shared.lock);
+
+  // reuse the blocks other threads gave back first
+  const auto [blocks, count] =
+      take_blocks(shared.free_lists[size_index], BLOCKS_PER_SLAB);
+  if (count != 0) {
+    cache.free_lists[size_index] = blocks;
+    cache.lengths[size_index] = count;
+    return;
+  }
+
+  const std::size_t block_size = BLOCK_SIZES[size_index];
+  auto *slab = static_cast<std::byte *>(
+      ::operator new(block_size * BLOCKS_PER_SLAB, SLAB_ALIGNMENT));
+  shared.slabs.push_back(slab);
+
+  for (std::size_t i = BLOCKS_PER_SLAB; i > 0; --i) {
+    auto *block = new (slab + ((i - 1) * block_size)) FreeBlock;
+    block->next = cache.free_lists[size_index];
+    cache.free_lists[size_index] = block;
+  }
+  cache.lengths[size_index] = BLOCKS_PER_SLAB;
+}
+
+// Hands one slab worth of the thread's blocks to the depot
+void spill(std::size_t size_index) {
+  const auto [blocks, count] =
+      take_blocks(cache.free_lists[size_index], BLOCKS_PER_SLAB);
+  cache.lengths[size_index] -= count;
+
+  FreeBlock *last = blocks;
+  while (last->next != nullptr) {
+    last = last->next;
+  }
+  Depot &shared = depot();
+  const std::lock_guard<std::mutex> guard(shared.lock);
+  last->next = shared.free_lists[size_index];
+  shared.free_lists[size_index] = blocks;
+}
+}  // namespace
+
+void *allocate_job_block(std::size_t size) {
+  const std::size_t size_index = size_class(size);
+  if (size_index == CLASS_COUNT) {
+    return ::operator new(size, SLAB_ALIGNMENT);
+  }
+
+  if (cache.free_lists[size_index] == nullptr) {
+    refill(size_index);
+  }
+  FreeBlock *block = cache.free_lists[size_index];
+  cache.free_lists[size_index] = block->next;
+  --cache.lengths[size_index];
+  return block;
+}
+
+void free_job_block(void *block, std::size_t size) {
+  const std::size_t size_index = size_class(size);
+  if (size_index == CLASS_COUNT) {
+    ::operator delete(block, SLAB_ALIGNMENT);
+    return;
+  }
+
+  auto *free_block = new (block) FreeBlock;
+  free_block->next = cache.free_lists[size_index];
+  cache.free_lists[size_index] = free_block;
+  if (++cache.lengths[size_index] >= SPILL_LENGTH) {
+    spill(size_index);
+  }
+}
+
+std::size_t job_slab_count() {
+  Depot &shared = depot();
+  const std::lock_guard<std::mutex> guard(shared.lock);
+  return shared.slabs.size();
+}
+}  // namespace ice_threading
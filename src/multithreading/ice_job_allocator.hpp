@@ -0,0 +1,31 @@
+#ifndef ICE_JOB_ALLOCATOR_HPP
+#define ICE_JOB_ALLOCATOR_HPP
+
+#include <cstddef>
+
+namespace ice_threading {
+
+/**
+ * Fixed-block allocator behind Job::operator new/delete.
+ * Blocks come in a few size classes and are carved out of slabs that are
+ * never returned, every thread keeps its own free lists so allocating and
+ * freeing a job is a pointer swap. A block freed on another thread than the
+ * one that allocated it joins that thread's lists; once a list holds two
+ * slabs worth of blocks, one slab worth goes back to a shared depot, which
+ * threads that run dry refill from before carving a new slab. So jobs made
+ * on one thread and deleted on others (every frame's jobs) keep cycling
+ * through the same slabs. Lists of exiting threads go back to the depot too.
+ * Sizes above the largest class fall back to the global heap.
+ */
+void *allocate_job_block(std::size_t size);
+void free_job_block(void *block, std::size_t size);
+
+// Slabs carved so far, by every thread.
+[[nodiscard]] std::size_t job_slab_count();
+
+// blocks are aligned to a cache line, so jobs on different threads never
+// share one
+inline constexpr std::size_t JOB_BLOCK_ALIGNMENT = 64;
+}  // namespace ice_threading
+
+#endif  // ICE_JOB_ALLOCATOR_HPP
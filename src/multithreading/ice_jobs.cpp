@@ -6,84 +6,66 @@ namespace ice_threading {
 
 // MakeModel
 MakeModel::MakeModel(ice::ObjMesh &mesh, const char *obj_filepath,
-                     const char *mtl_filepath, glm::mat4 pre_transform)
-    : mesh(mesh), pre_transform(pre_transform) {
+                     const char *mtl_filepath, glm::mat4 pre_transform,
+                     Scheduler *scheduler)
+    : mesh(mesh), pre_transform(pre_transform), scheduler(scheduler) {
+  trace_name = "MakeModel";
   this->obj_filepath = obj_filepath;
   this->mtl_filepath = mtl_filepath;
 }
 
 // NOLINTBEGIN (misc-unused-parameters)
 void MakeModel::execute(vk::CommandBuffer command_buffer, vk::Queue queue) {
-  mesh.load(obj_filepath, mtl_filepath, pre_transform);
-  status = JobStatus::COMPLETE;
+  mesh.load(obj_filepath, mtl_filepath, pre_transform, scheduler);
 }
 // NOLINTEND (misc-unused-parameters)
 
-// MakeTexture
-MakeTexture::MakeTexture(std::shared_ptr<ice_image::Texture> texture,
-                         ice_image::TextureCreationInput texture_info)
-    : texture(std::move(texture)), texture_info(std::move(texture_info)) {}
-
-void MakeTexture::execute(vk::CommandBuffer command_buffer, vk::Queue queue) {
-  texture_info.command_buffer = command_buffer;
-  texture_info.queue = queue;
-  texture->load(texture_info);
-  status = JobStatus::COMPLETE;
-}
-
-// WorkQueue
-void WorkQueue::add(Job *job) {
-  if (length == 0) {
-    first = job;
-    last = job;
-  } else {
-    last->next = job;
-    last = job;
-  }
-
-  length += 1;
-}
-
-Job *WorkQueue::get_next() const {
-  Job *current = first;
-  while (current) {
-    if (current->status == JobStatus::PENDING) {
-      return current;
+// decode_texture
+Task<> decode_texture(IoThread &io, Scheduler &scheduler,
+                      std::shared_ptr<ice_image::Texture> texture,
+                      ice_image::TextureCreationInput texture_info) {
+  // a baked mip chain spares decoding the image file and making its mips,
+  // it is read on the I/O thread too
+  const std::string &source = texture_info.filenames[0];
+  if (const std::optional<std::string> baked =
+          ice_image::find_baked_texture(source)) {
+    const std::vector<unsigned char> contents =
+        co_await read_file(io, scheduler, *baked);
+    if (texture->decode_baked(
+            texture_info,
+            {reinterpret_cast<const char *>(contents.data()),
+             contents.size()})) {
+      co_return;
     }
-
-    current = current->next;
-  }
-
-  return nullptr;
-}
-
-bool WorkQueue::done() const {
-  Job *current = first;
-  while (current) {
-    if (current->status != JobStatus::COMPLETE) {
-      return false;
+    if (*baked == source) {
+      // a .ktx2 file that is unusable here, nothing else to decode
+      texture->decode(texture_info, contents);
+      co_return;
     }
-
-    current = current->next;
   }
+  const std::vector<unsigned char> encoded =
+      co_await read_file(io, scheduler, source);
+  texture->decode(texture_info, encoded);
+}
 
-  return true;
+// UploadTexture
+UploadTexture::UploadTexture(std::shared_ptr<ice_image::Texture> texture)
+    : texture(std::move(texture)) {
+  trace_name = "UploadTexture";
 }
 
-void WorkQueue::clear() {
-  if (length == 0) {
-    return;
-  }
+void UploadTexture::execute(vk::CommandBuffer command_buffer,
+                            vk::Queue queue) {
+  texture->upload(command_buffer, queue);
+}
 
-  Job *current = first;
-  while (current) {
-    Job *previous = current;
-    current = current->next;
-    delete previous;
-  }
+// FunctionJob
+FunctionJob::FunctionJob(Function function) : function(std::move(function)) {
+  trace_name = "FunctionJob";
+}
 
-  first = nullptr;
-  last = nullptr;
-  length = 0;
+void FunctionJob::execute(vk::CommandBuffer command_buffer, vk::Queue queue) {
+  function(command_buffer, queue);
 }
+
 }  // namespace ice_threading
@@ -6,17 +6,11 @@
 #include "../images/ice_texture.hpp"
 #include "../mesh.hpp"
 #include "images/ice_image.hpp"
+#include "ice_inline_function.hpp"
+#include "ice_io_thread.hpp"
+#include "ice_scheduler.hpp"
 
 namespace ice_threading {
-enum class JobStatus { PENDING, IN_PROGRESS, COMPLETE };
-
-class Job {
- public:
-  virtual ~Job() = default;
-  JobStatus status = JobStatus::PENDING;
-  Job *next = nullptr;
-  virtual void execute(vk::CommandBuffer command_buffer, vk::Queue queue) = 0;
-};
 
 class MakeModel : public Job {
  public:
@@ -24,29 +18,37 @@ class MakeModel : public Job {
   const char *mtl_filepath;
   glm::mat4 pre_transform;
   ice::ObjMesh &mesh;
+  Scheduler *scheduler;  // parses large files in parallel, if not null
   MakeModel(ice::ObjMesh &mesh, const char *obj_filepath,
-            const char *mtl_filepath, glm::mat4 pre_transform);
+            const char *mtl_filepath, glm::mat4 pre_transform,
+            Scheduler *scheduler = nullptr);
   void execute(vk::CommandBuffer command_buffer, vk::Queue queue) final;
 };
 
-class MakeTexture : public Job {
+// First stage of a texture: reads its baked mip chain, or if it has no up
+// to date one the image file, on the I/O thread, then decodes (and bakes)
+// it on the scheduler (CPU only). Run it through a TaskJob.
+Task<> decode_texture(IoThread &io, Scheduler &scheduler,
+                      std::shared_ptr<ice_image::Texture> texture,
+                      ice_image::TextureCreationInput texture_info);
+
+// Second stage of a texture: creates the image and uploads the decoded
+// pixels with the executing thread's command buffer
+class UploadTexture : public Job {
  public:
-  ice_image::TextureCreationInput texture_info;
   std::shared_ptr<ice_image::Texture> texture;
-  MakeTexture(std::shared_ptr<ice_image::Texture> texture,
-              ice_image::TextureCreationInput texture_info);
+  explicit UploadTexture(std::shared_ptr<ice_image::Texture> texture);
   void execute(vk::CommandBuffer command_buffer, vk::Queue queue) final;
 };
 
-class WorkQueue {
+// Runs a callable, for one-off nodes of a job graph and per-frame work. The
+// captures are stored inside the job.
+class FunctionJob : public Job {
  public:
-  Job *first = nullptr, *last = nullptr;
-  std::size_t length{};
-  std::mutex lock;
-  void add(Job *job);
-  [[nodiscard]] Job *get_next() const;
-  [[nodiscard]] bool done() const;
-  void clear();
+  using Function = InlineFunction<void(vk::CommandBuffer, vk::Queue)>;
+  Function function;
+  explicit FunctionJob(Function function);
+  void execute(vk::CommandBuffer command_buffer, vk::Queue queue) final;
 };
 }  // namespace ice_threading
 
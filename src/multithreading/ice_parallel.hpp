@@ -0,0 +1,111 @@
+#ifndef ICE_PARALLEL_HPP
+#define ICE_PARALLEL_HPP
+
+#include <algorithm>
+#include <type_traits>
+
+#include "ice_scheduler.hpp"
+
+namespace ice_threading {
+
+namespace detail {
+// Runs function over [begin, end), function must outlive the job
+template <typename Function>
+class RangeJob : public Job {
+ public:
+  RangeJob(const Function &function, std::size_t begin, std::size_t end)
+      : function(function), begin(begin), end(end) {
+    trace_name = "parallel_for";
+  }
+
+  void execute(vk::CommandBuffer, vk::Queue) final { function(begin, end); }
+
+ private:
+  const Function &function;
+  std::size_t begin, end;
+};
+}  // namespace detail
+
+/**
+ * Splits [begin, end) into chunks of grain_size indices and calls
+ * function(chunk_begin, chunk_end) for each of them on the scheduler's
+ * threads. The calling thread runs the first chunk itself and helps with the
+ * rest, returning once every chunk has completed. Pick grain_size so a chunk
+ * is worth a job (thousands of cheap iterations, not a handful).
+ * With a null scheduler, or a single chunk, everything runs inline.
+ */
+template <typename Function>
+void parallel_for(Scheduler *scheduler, std::size_t begin, std::size_t end,
+                  std::size_t grain_size, const Function &function) {
+  if (end <= begin) {
+    return;
+  }
+  grain_size = std::max<std::size_t>(grain_size, 1);
+  const std::size_t chunk_count = (end - begin + grain_size - 1) / grain_size;
+
+  if (scheduler == nullptr || chunk_count == 1) {
+    function(begin, end);
+    return;
+  }
+
+  // chunks run at the priority of the job that spawned them
+  const JobPriority priority = Scheduler::current_priority();
+  JobCounter counter;
+  for (std::size_t chunk = 1; chunk < chunk_count; ++chunk) {
+    const std::size_t chunk_begin = begin + chunk * grain_size;
+    auto *job = new detail::RangeJob<Function>(
+        function, chunk_begin, std::min(chunk_begin + grain_size, end));
+    job->priority = priority;
+    scheduler->submit(job, &counter);
+  }
+
+  try {
+    function(begin, begin + grain_size);
+  } catch (...) {
+    // the submitted chunks still reference function
+    scheduler->wait(counter);
+    throw;
+  }
+  scheduler->wait(counter);
+}
+
+/**
+ * Chunked reduction over [begin, end). function(chunk_begin, chunk_end)
+ * returns the partial result of one chunk, the partials are then folded with
+ * combine(accumulated, partial) starting from identity. Partials are combined
+ * in chunk order, so the result does not depend on scheduling (even for
+ * floating point).
+ */
+template <typename T, typename Function, typename Combine>
+T parallel_reduce(Scheduler *scheduler, std::size_t begin, std::size_t end,
+                  std::size_t grain_size, T identity, const Function &function,
+                  const Combine &combine) {
+  // chunks write their partials concurrently, std::vector<bool> packs them
+  static_assert(!std::is_same_v<T, bool>, "use an integral type for flags");
+
+  if (end <= begin) {
+    return identity;
+  }
+  grain_size = std::max<std::size_t>(grain_size, 1);
+  const std::size_t chunk_count = (end - begin + grain_size - 1) / grain_size;
+
+  std::vector<T> partials(chunk_count, identity);
+  parallel_for(scheduler, 0, chunk_count, 1,
+               [&](std::size_t first_chunk, std::size_t last_chunk) {
+                 for (std::size_t chunk = first_chunk; chunk < last_chunk;
+                      ++chunk) {
+                   const std::size_t chunk_begin = begin + chunk * grain_size;
+                   partials[chunk] = function(
+                       chunk_begin, std::min(chunk_begin + grain_size, end));
+                 }
+               });
+
+  T result = identity;
+  for (const T &partial : partials) {
+    result = combine(result, partial);
+  }
+  return result;
+}
+}  // namespace ice_threading
+
+#endif  // ICE_PARALLEL_HPP
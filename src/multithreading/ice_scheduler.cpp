@@ -0,0 +1,401 @@
+#include "ice_scheduler.hpp"
+
+#include <algorithm>
+
+namespace ice_threading {
+
+namespace {
+constexpr std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+// Thread binding, set by Scheduler::register_thread
+thread_local const Scheduler *current_scheduler = nullptr;
+thread_local std::size_t current_slot = NO_SLOT;
+thread_local WorkerContext thread_context{};
+thread_local Job *current_job = nullptr;
+
+// cheap per-thread generator for picking steal victims
+thread_local std::uint32_t victim_seed = 0x9E3779B9u;
+
+std::uint32_t next_victim_seed() {
+  victim_seed ^= victim_seed << 13;
+  victim_seed ^= victim_seed >> 17;
+  victim_seed ^= victim_seed << 5;
+  return victim_seed;
+}
+}  // namespace
+
+// JobCounter
+void JobCounter::add(std::uint32_t count) {
+  value.fetch_add(count, std::memory_order_relaxed);
+}
+
+void JobCounter::decrement() {
+  // lock free unless this may be the last job of the batch
+  std::uint32_t current = value.load(std::memory_order_relaxed);
+  while (current > 1) {
+    if (value.compare_exchange_weak(current, current - 1,
+                                    std::memory_order_acq_rel,
+                                    std::memory_order_relaxed)) {
+      return;
+    }
+  }
+
+  // reach zero and notify under the lock: a waiter may destroy the counter
+  // as soon as it observes zero
+  const std::lock_guard<std::mutex> guard(lock);
+  if (value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    zero.notify_all();
+  }
+}
+
+void JobCounter::wait() {
+  std::unique_lock<std::mutex> guard(lock);
+  zero.wait(guard, [this] { return is_done(); });
+}
+
+// Job
+bool Job::cancelled() const {
+  if (cancellation.cancelled()) {
+    return true;
+  }
+  return deadline != JobClock::time_point::max() && JobClock::now() > deadline;
+}
+
+void Job::depends_on(Job *predecessor) {
+  unfinished_dependencies.fetch_add(1, std::memory_order_relaxed);
+  if (predecessor->continuation_count <
+      predecessor->inline_continuations.size()) {
+    predecessor->inline_continuations[predecessor->continuation_count] = this;
+  } else {
+    predecessor->more_continuations.push_back(this);
+  }
+  ++predecessor->continuation_count;
+}
+
+// Scheduler
+Scheduler::Scheduler(std::size_t worker_count) {
+  // the owning thread + one slot per worker
+  slots.reserve(worker_count + 1);
+  for (std::size_t i = 0; i < worker_count + 1; ++i) {
+    slots.push_back(std::make_unique<Slot>());
+  }
+}
+
+Scheduler::~Scheduler() {
+  // Delete jobs that never ran
+  for (auto &slot : slots) {
+    for (auto &deque : slot->deques) {
+      while (Job *job = deque.steal()) {
+        delete job;
+      }
+    }
+  }
+  for (InjectionQueue &queue : injected) {
+    for (Job *job : queue.jobs) {
+      delete job;
+    }
+  }
+  // Jobs kept from finishing by a suspended coroutine (TaskJobs) own its
+  // frame, the ResumeJobs that would have resumed it were dropped above
+  for (const auto &[job, count] : deferred) {
+    delete job;
+  }
+}
+
+void Scheduler::register_thread(std::size_t slot, WorkerContext context) {
+  current_scheduler = this;
+  current_slot = slot;
+  thread_context = context;
+  victim_seed ^= static_cast<std::uint32_t>(slot + 1) * 0x85EBCA6Bu;
+}
+
+void Scheduler::submit(Job *job, JobCounter *counter) {
+  job->status.store(JobStatus::PENDING, std::memory_order_relaxed);
+  job->counter = counter;
+  if (counter != nullptr) {
+    counter->add();
+  }
+  unfinished.fetch_add(1, std::memory_order_relaxed);
+
+  // drop the submission reference, if predecessors are still running the
+  // last one to finish enqueues the job
+  if (job->unfinished_dependencies.fetch_sub(1, std::memory_order_acq_rel) ==
+      1) {
+    enqueue(job);
+  }
+}
+
+void Scheduler::submit_child(Job *child, JobCounter *counter) {
+  Job *parent = current_job;
+  if (parent == nullptr) {
+    throw std::logic_error("submit_child called outside of a running job");
+  }
+
+  parent->unfinished_work.fetch_add(1, std::memory_order_relaxed);
+  child->parent = parent;
+  child->priority = parent->priority;
+  child->cancellation = parent->cancellation;
+  submit(child, counter);
+}
+
+void Scheduler::release(Job *continuation, bool cancelled) {
+  if (cancelled) {
+    continuation->predecessor_cancelled.store(true, std::memory_order_relaxed);
+  }
+  if (continuation->unfinished_dependencies.fetch_sub(
+          1, std::memory_order_acq_rel) == 1) {
+    enqueue(continuation);
+  }
+}
+
+void Scheduler::enqueue(Job *job) {
+  job->enqueued_at = JobClock::now();
+  const auto priority = static_cast<std::size_t>(job->priority);
+
+  if (current_scheduler == this && current_slot < slots.size()) {
+    slots[current_slot]->deques[priority].push(job);
+  } else {
+    InjectionQueue &queue = injected[priority];
+    const std::lock_guard<std::mutex> guard(queue.lock);
+    queue.jobs.push_back(job);
+    queue.count.fetch_add(1, std::memory_order_release);
+  }
+
+  // wake a parked worker, if there is one. Pairs with the fence in
+  // wait_for_work(): either the worker sees this job or we see it parked.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (parked.load(std::memory_order_relaxed) != 0) {
+    epoch.fetch_add(1, std::memory_order_release);
+    epoch.notify_one();
+  }
+}
+
+bool Scheduler::has_work() const {
+  for (const std::unique_ptr<Slot> &slot : slots) {
+    for (const WorkStealingDeque<Job> &deque : slot->deques) {
+      if (!deque.empty()) {
+        return true;
+      }
+    }
+  }
+  return std::any_of(injected.begin(), injected.end(),
+                     [](const InjectionQueue &queue) {
+                       return queue.count.load(std::memory_order_relaxed) != 0;
+                     });
+}
+
+Job *Scheduler::take_injected(std::size_t priority) {
+  InjectionQueue &queue = injected[priority];
+  if (queue.count.load(std::memory_order_acquire) == 0) {
+    return nullptr;
+  }
+
+  const std::lock_guard<std::mutex> guard(queue.lock);
+  if (queue.jobs.empty()) {
+    return nullptr;
+  }
+  Job *job = queue.jobs.front();
+  queue.jobs.pop_front();
+  queue.count.fetch_sub(1, std::memory_order_relaxed);
+  return job;
+}
+
+Job *Scheduler::get_next() {
+  const bool bound = current_scheduler == this && current_slot < slots.size();
+  const std::size_t slot_total = slots.size();
+  const std::size_t start = next_victim_seed() % slot_total;
+
+  for (std::size_t priority = 0; priority < PRIORITY_COUNT; ++priority) {
+    if (bound) {
+      if (Job *job = slots[current_slot]->deques[priority].pop()) {
+        return job;
+      }
+    }
+
+    if (Job *job = take_injected(priority)) {
+      return job;
+    }
+
+    // steal, starting from a random victim to spread contention
+    for (std::size_t i = 0; i < slot_total; ++i) {
+      const std::size_t victim = (start + i) % slot_total;
+      if (bound && victim == current_slot) {
+        continue;
+      }
+      if (Job *job = slots[victim]->deques[priority].steal()) {
+        return job;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+void Scheduler::run(Job *job) {
+  Job *const previous_job = current_job;  // run() may nest
+  current_job = job;
+
+  const bool dropped =
+      job->predecessor_cancelled.load(std::memory_order_relaxed) ||
+      job->cancelled();
+  record_dequeue(job, dropped);
+
+  if (dropped) {
+    job->status.store(JobStatus::CANCELLED, std::memory_order_relaxed);
+  } else {
+    job->status.store(JobStatus::IN_PROGRESS, std::memory_order_relaxed);
+    const TraceScope trace(job->trace_name, TraceCategory::JOB);
+    job->execute(thread_context.command_buffer, thread_context.queue);
+  }
+
+  current_job = previous_job;
+  finish(job);
+}
+
+void Scheduler::record_dequeue(Job *job, bool dropped) {
+  AtomicPriorityStats &stats =
+      priority_stats[static_cast<std::size_t>(job->priority)];
+  if (dropped) {
+    stats.cancelled.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  const std::int64_t wait_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(JobClock::now() -
+                                                           job->enqueued_at)
+          .count();
+  stats.executed.fetch_add(1, std::memory_order_relaxed);
+  stats.total_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+
+  std::int64_t max_wait = stats.max_wait_ns.load(std::memory_order_relaxed);
+  while (wait_ns > max_wait &&
+         !stats.max_wait_ns.compare_exchange_weak(max_wait, wait_ns,
+                                                  std::memory_order_relaxed)) {
+  }
+}
+
+void Scheduler::finish(Job *job) {
+  // walk up while the last piece of work of each ancestor completes
+  while (job != nullptr) {
+    if (job->unfinished_work.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return;
+    }
+
+    // a cancelled job keeps its status, and its continuations are dropped too
+    const bool cancelled =
+        job->status.load(std::memory_order_relaxed) == JobStatus::CANCELLED;
+    if (!cancelled) {
+      job->status.store(JobStatus::COMPLETE, std::memory_order_release);
+    }
+    const std::size_t inline_count =
+        std::min<std::size_t>(job->continuation_count,
+                              job->inline_continuations.size());
+    for (std::size_t i = 0; i < inline_count; ++i) {
+      release(job->inline_continuations[i], cancelled);
+    }
+    for (Job *continuation : job->more_continuations) {
+      release(continuation, cancelled);
+    }
+
+    JobCounter *counter = job->counter;
+    Job *parent = job->parent;
+    delete job;
+    unfinished.fetch_sub(1, std::memory_order_acq_rel);
+    if (counter != nullptr) {
+      counter->decrement();
+    }
+    job = parent;
+  }
+}
+
+void Scheduler::wait(JobCounter &counter) {
+  while (!counter.is_done()) {
+    Job *job = get_next();
+    if (job == nullptr) {
+      break;
+    }
+    run(job);
+  }
+  if (!counter.is_done()) {
+    // only the blocking part, the jobs run above are traced themselves
+    const TraceScope trace("wait for jobs", TraceCategory::WAIT);
+    counter.wait();
+  } else {
+    // the last decrement may still hold the lock, the caller is free to
+    // destroy the counter once it was released
+    counter.wait();
+  }
+}
+
+void Scheduler::defer_finish(Job *job) {
+  job->unfinished_work.fetch_add(1, std::memory_order_relaxed);
+  const std::lock_guard<std::mutex> guard(deferred_lock);
+  ++deferred[job];
+}
+
+void Scheduler::finish_deferred(Job *job) {
+  {
+    const std::lock_guard<std::mutex> guard(deferred_lock);
+    const auto entry = deferred.find(job);
+    if (--entry->second == 0) {
+      deferred.erase(entry);
+    }
+  }
+  finish(job);
+}
+
+WorkerContext Scheduler::current_context() { return thread_context; }
+
+JobPriority Scheduler::current_priority() {
+  return current_job != nullptr ? current_job->priority : JobPriority::NORMAL;
+}
+
+Scheduler::Stats Scheduler::stats() const {
+  Stats snapshot{};
+  for (std::size_t i = 0; i < PRIORITY_COUNT; ++i) {
+    const AtomicPriorityStats &stats = priority_stats[i];
+    snapshot[i] = {
+        .executed = stats.executed.load(std::memory_order_relaxed),
+        .cancelled = stats.cancelled.load(std::memory_order_relaxed),
+        .total_wait = std::chrono::nanoseconds(
+            stats.total_wait_ns.load(std::memory_order_relaxed)),
+        .max_wait = std::chrono::nanoseconds(
+            stats.max_wait_ns.load(std::memory_order_relaxed))};
+  }
+  return snapshot;
+}
+
+void Scheduler::reset_stats() {
+  for (AtomicPriorityStats &stats : priority_stats) {
+    stats.executed.store(0, std::memory_order_relaxed);
+    stats.cancelled.store(0, std::memory_order_relaxed);
+    stats.total_wait_ns.store(0, std::memory_order_relaxed);
+    stats.max_wait_ns.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool Scheduler::done() const {
+  return unfinished.load(std::memory_order_acquire) == 0;
+}
+
+void Scheduler::wait_for_work(std::uint32_t seen_epoch) {
+  if (stopped()) {
+    return;
+  }
+  // submissions only wake anyone while a worker is parked, look for work
+  // once more after announcing it
+  parked.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!has_work()) {
+    epoch.wait(seen_epoch, std::memory_order_acquire);
+  }
+  parked.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Scheduler::stop() {
+  stopping.store(true, std::memory_order_release);
+  epoch.fetch_add(1, std::memory_order_release);
+  epoch.notify_all();
+}
+
+}  // namespace ice_threading
@@ -0,0 +1,294 @@
+#ifndef ICE_SCHEDULER_HPP
+#define ICE_SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+
+#include "../config.hpp"
+#include "ice_job_allocator.hpp"
+#include "ice_trace.hpp"
+#include "ice_work_stealing_deque.hpp"
+
+namespace ice_threading {
+enum class JobStatus { PENDING, IN_PROGRESS, COMPLETE, CANCELLED };
+
+// Higher priorities are always taken first: HIGH for the current frame and
+// visible assets, LOW for background prefetch
+enum class JobPriority { HIGH, NORMAL, LOW };
+inline constexpr std::size_t PRIORITY_COUNT = 3;
+
+using JobClock = std::chrono::steady_clock;
+
+/**
+ * Shared flag for cooperative cancellation. Copies refer to the same flag,
+ * hand one to every job of a request and cancel() them all at once. Jobs
+ * that have not started are dropped, running ones may poll
+ * Job::cancelled(). A default constructed token can never be cancelled.
+ */
+class CancellationToken {
+ public:
+  CancellationToken() = default;
+  [[nodiscard]] static CancellationToken make() {
+    CancellationToken token;
+    token.flag = std::make_shared<std::atomic<bool>>(false);
+    return token;
+  }
+
+  void cancel() const {
+    if (flag) {
+      flag->store(true, std::memory_order_release);
+    }
+  }
+  [[nodiscard]] bool cancelled() const {
+    return flag && flag->load(std::memory_order_acquire);
+  }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> flag;
+};
+
+/**
+ * Counts the outstanding jobs of a batch. Threads blocked in wait() are woken
+ * as soon as the last job of the batch completes.
+ */
+class JobCounter {
+ public:
+  JobCounter() = default;
+  JobCounter(const JobCounter &) = delete;
+  JobCounter &operator=(const JobCounter &) = delete;
+
+  void add(std::uint32_t count = 1);
+  void decrement();
+
+  [[nodiscard]] bool is_done() const {
+    return value.load(std::memory_order_acquire) == 0;
+  }
+
+  // Blocks the calling thread until the counter drops to zero. The counter
+  // may be destroyed once it returned (unlike after is_done()).
+  void wait();
+
+ private:
+  std::atomic<std::uint32_t> value{0};
+  std::mutex lock;
+  std::condition_variable zero;
+};
+
+class Scheduler;
+
+/**
+ * Unit of work run by the Scheduler.
+ * Jobs form a graph: depends_on() delays a job until its predecessors have
+ * finished, and jobs spawned through Scheduler::submit_child() extend their
+ * parent, which only finishes (and releases its own continuations) once all
+ * of its children have.
+ * A job that is cancelled or past its deadline when it is dequeued is not
+ * executed, its status becomes CANCELLED and its continuations are dropped
+ * as well; counters and parents still see it finish.
+ */
+class Job {
+ public:
+  virtual ~Job() = default;
+
+  // jobs live in fixed-size blocks, see ice_job_allocator.hpp
+  static void *operator new(std::size_t size) {
+    return allocate_job_block(size);
+  }
+  static void operator delete(void *block, std::size_t size) {
+    free_job_block(block, size);
+  }
+
+  std::atomic<JobStatus> status{JobStatus::PENDING};
+  JobCounter *counter = nullptr;  // decremented once the job completed
+  virtual void execute(vk::CommandBuffer command_buffer, vk::Queue queue) = 0;
+
+  // Set before submitting.
+  JobPriority priority{JobPriority::NORMAL};
+  CancellationToken cancellation;
+  JobClock::time_point deadline{JobClock::time_point::max()};
+  // shown in traces, must outlive the trace export (a string literal)
+  const char *trace_name = "Job";
+
+  // true once the job should stop, long running jobs may poll this
+  [[nodiscard]] bool cancelled() const;
+
+  /**
+   * This job will not start before predecessor has finished. Edges must be
+   * declared before either job is submitted.
+   */
+  void depends_on(Job *predecessor);
+
+ private:
+  friend class Scheduler;
+
+  // one extra reference is held until the job is submitted
+  std::atomic<std::uint32_t> unfinished_dependencies{1};
+  // the job itself plus its unfinished children
+  std::atomic<std::uint32_t> unfinished_work{1};
+  // the first few continuations are stored inline
+  std::array<Job *, 3> inline_continuations{};
+  std::vector<Job *> more_continuations;
+  std::uint32_t continuation_count = 0;
+  Job *parent = nullptr;
+  // set when a predecessor was cancelled, read once this job is released
+  std::atomic<bool> predecessor_cancelled{false};
+  JobClock::time_point enqueued_at;
+};
+
+// Per-thread resources handed to the jobs a thread executes.
+struct WorkerContext {
+  vk::CommandBuffer command_buffer;
+  vk::Queue queue;
+};
+
+/**
+ * Work-stealing job scheduler.
+ * Slot 0 belongs to the thread that owns the scheduler (the main thread),
+ * slots 1..worker_count to the worker threads. Every slot has its own deque:
+ * the thread bound to it pushes and pops at the bottom, idle threads steal
+ * from the top of the other deques. Threads not bound to a slot submit
+ * through a locked injection queue. Workers that find no work park until
+ * the next submission instead of polling.
+ * Every priority has its own deques and injection queue, a thread only
+ * looks at a lower priority once it found nothing of a higher one anywhere.
+ */
+class Scheduler {
+ public:
+  explicit Scheduler(std::size_t worker_count);
+  ~Scheduler();
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  [[nodiscard]] std::size_t slot_count() const { return slots.size(); }
+
+  // Binds the calling thread to a slot and the resources its jobs will use.
+  void register_thread(std::size_t slot, WorkerContext context);
+
+  // Queue a job, the scheduler takes ownership and deletes it once finished.
+  // If a counter is given it is incremented now and decremented on
+  // completion. Jobs with unfinished dependencies are held back until their
+  // last predecessor finishes.
+  void submit(Job *job, JobCounter *counter = nullptr);
+
+  // Submit from inside a running job: the running job will not finish
+  // before the child has. The child inherits the parent's priority and
+  // cancellation token.
+  void submit_child(Job *child, JobCounter *counter = nullptr);
+
+  // Next job for the calling thread: its own deque first, then stealing.
+  // Returns nullptr if no work was found.
+  [[nodiscard]] Job *get_next();
+
+  // Executes a job on the calling thread, then retires it once its children
+  // are done.
+  void run(Job *job);
+
+  /**
+   * Blocks until counter drops to zero. The calling thread runs queued jobs
+   * while any are left (which may include jobs unrelated to counter), then
+   * sleeps on the counter for the ones still running elsewhere.
+   */
+  void wait(JobCounter &counter);
+
+  // true when every submitted job has completed
+  [[nodiscard]] bool done() const;
+
+  /**
+   * Keeps a running job from finishing when execute() returns, e.g. while a
+   * coroutine it started is suspended. Every defer_finish() needs one
+   * finish_deferred(), which may complete and delete the job. Jobs still
+   * deferred when the scheduler is destroyed are deleted with it.
+   */
+  void defer_finish(Job *job);
+  void finish_deferred(Job *job);
+
+  // Priority of the job running on the calling thread, NORMAL outside jobs.
+  [[nodiscard]] static JobPriority current_priority();
+
+  // Resources of the calling thread, empty for threads without a slot.
+  [[nodiscard]] static WorkerContext current_context();
+
+  struct PriorityStats {
+    std::uint64_t executed{0};
+    std::uint64_t cancelled{0};
+    // time from being enqueued (runnable) to being picked up
+    std::chrono::nanoseconds total_wait{0};
+    std::chrono::nanoseconds max_wait{0};
+  };
+  using Stats = std::array<PriorityStats, PRIORITY_COUNT>;
+
+  // Snapshot of the queue wait statistics per priority, indexed by
+  // JobPriority.
+  [[nodiscard]] Stats stats() const;
+  void reset_stats();
+
+  /**
+   * Parking for idle threads. Read the epoch before looking for work, then
+   * pass it to wait_for_work() if nothing was found: a submission made in
+   * between either changes the epoch or is found by wait_for_work() before
+   * it parks, so no wake-up can be lost. Submissions only touch the epoch
+   * while a thread is parked.
+   */
+  [[nodiscard]] std::uint32_t work_epoch() const {
+    return epoch.load(std::memory_order_acquire);
+  }
+  void wait_for_work(std::uint32_t seen_epoch);
+
+  /**
+   * Makes the workers leave, jobs still queued are not run: ~Scheduler
+   * deletes them and the deferred jobs. Whatever can still submit, e.g. the
+   * completions of an IoThread or SubmissionThread resuming coroutines here,
+   * has to be shut down before the scheduler is destroyed.
+   */
+  void stop();
+  [[nodiscard]] bool stopped() const {
+    return stopping.load(std::memory_order_acquire);
+  }
+
+ private:
+  void enqueue(Job *job);
+  // true if any deque or injection queue holds a job (approximate)
+  [[nodiscard]] bool has_work() const;
+  // drops one dependency of a continuation, enqueueing it on the last one
+  void release(Job *continuation, bool cancelled);
+  void finish(Job *job);
+  [[nodiscard]] Job *take_injected(std::size_t priority);
+  void record_dequeue(Job *job, bool dropped);
+
+  struct Slot {
+    std::array<WorkStealingDeque<Job>, PRIORITY_COUNT> deques;
+  };
+  std::vector<std::unique_ptr<Slot>> slots;
+
+  // submissions from threads without a slot
+  struct InjectionQueue {
+    std::deque<Job *> jobs;
+    std::mutex lock;
+    std::atomic<std::size_t> count{0};
+  };
+  std::array<InjectionQueue, PRIORITY_COUNT> injected;
+
+  struct AtomicPriorityStats {
+    std::atomic<std::uint64_t> executed{0};
+    std::atomic<std::uint64_t> cancelled{0};
+    std::atomic<std::int64_t> total_wait_ns{0};
+    std::atomic<std::int64_t> max_wait_ns{0};
+  };
+  std::array<AtomicPriorityStats, PRIORITY_COUNT> priority_stats;
+
+  // jobs between defer_finish() and their last finish_deferred()
+  std::unordered_map<Job *, std::uint32_t> deferred;
+  std::mutex deferred_lock;
+
+  std::atomic<std::size_t> unfinished{0};
+  std::atomic<std::uint32_t> epoch{0};
+  std::atomic<std::uint32_t> parked{0};  // threads in wait_for_work()
+  std::atomic<bool> stopping{false};
+};
+}  // namespace ice_threading
+
+#endif  // ICE_SCHEDULER_HPP
@@ -0,0 +1,222 @@
+#include "ice_submission_thread.hpp"
+
+namespace ice_threading {
+
+namespace {
+std::atomic<SubmissionThread *> queue_owner{nullptr};
+}  // namespace
+
+SubmissionThread::SubmissionThread(vk::Device device, vk::Queue queue,
+                                   uint32_t queue_family_index)
+    : device(device),
+      queue(queue),
+      queue_family_index(queue_family_index),
+      retire_thread(
+          [this](const std::stop_token &stop) { run_retire(stop); }),
+      thread([this](const std::stop_token &stop) { run(stop); }) {
+  queue_owner.store(this, std::memory_order_release);
+}
+
+SubmissionThread::~SubmissionThread() {
+  queue_owner.store(nullptr, std::memory_order_release);
+
+  thread.request_stop();
+  thread.join();
+  // nothing is submitted anymore, the retire thread leaves once every
+  // upload in flight completed
+  retire_thread.request_stop();
+  retire_thread.join();
+
+  for (const vk::Fence fence : fences) {
+    device.destroyFence(fence);
+  }
+}
+
+SubmissionThread *SubmissionThread::owner_of(vk::Queue queue) {
+  SubmissionThread *owner = queue_owner.load(std::memory_order_acquire);
+  return (owner != nullptr && owner->queue == queue) ? owner : nullptr;
+}
+
+vk::Result SubmissionThread::submit_and_wait(vk::CommandBuffer command_buffer) {
+  const vk::Fence fence = acquire_fence();
+
+  std::future<vk::Result> submitted;
+  {
+    const std::lock_guard<std::mutex> guard(request_lock);
+    requests.push_back({.command_buffer = command_buffer, .fence = fence});
+    submitted = requests.back().submitted.get_future();
+  }
+  pending.notify_one();
+
+  // a failed submit never signals the fence
+  const vk::Result result = submitted.get();
+  if (result == vk::Result::eSuccess) {
+    const TraceScope trace("wait for upload", TraceCategory::WAIT);
+    const vk::Result wait_result =
+        device.waitForFences(1, &fence, vk::True, UINT64_MAX);
+    if (wait_result != vk::Result::eSuccess) {
+#ifndef NDEBUG
+      std::cerr << std::format("Waiting for an upload failed: {}\n",
+                               vk::to_string(wait_result));
+#endif
+    }
+  }
+
+  release_fence(fence);
+  return result;
+}
+
+SubmissionThread::TransientCommands
+SubmissionThread::make_transient_commands() {
+  const vk::CommandPoolCreateInfo pool_info{
+      .flags = vk::CommandPoolCreateFlagBits::eTransient,
+      .queueFamilyIndex = queue_family_index};
+  TransientCommands commands;
+  commands.command_pool = device.createCommandPool(pool_info);
+
+  const vk::CommandBufferAllocateInfo alloc_info{
+      .commandPool = commands.command_pool,
+      .level = vk::CommandBufferLevel::ePrimary,
+      .commandBufferCount = 1};
+  commands.command_buffer = device.allocateCommandBuffers(alloc_info)[0];
+  return commands;
+}
+
+void SubmissionThread::submit_async(TransientCommands commands,
+                                    Completion on_complete) {
+  const vk::Fence fence = acquire_fence();
+  {
+    const std::lock_guard<std::mutex> guard(request_lock);
+    requests.push_back({.command_buffer = commands.command_buffer,
+                        .fence = fence,
+                        .command_pool = commands.command_pool,
+                        .on_complete = std::move(on_complete)});
+  }
+  pending.notify_one();
+}
+
+void SubmissionThread::run(const std::stop_token &stop) {
+  set_trace_thread_name("submission");
+  std::vector<Request> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(request_lock);
+      pending.wait(guard, stop, [this] { return !requests.empty(); });
+      if (requests.empty()) {
+        return;  // stop requested, every request was submitted
+      }
+      batch.swap(requests);
+    }
+
+    submit(batch);
+  }
+}
+
+void SubmissionThread::submit(std::vector<Request> &batch) {
+  bool added = false;
+  {
+    // vkQueueSubmit takes a single fence, so requests go one by one
+    const std::lock_guard<std::mutex> guard(queue_lock);
+    const TraceScope trace("vkQueueSubmit", TraceCategory::SUBMIT);
+    for (Request &request : batch) {
+      const vk::SubmitInfo submit_info{
+          .commandBufferCount = 1, .pCommandBuffers = &request.command_buffer};
+      const vk::Result result = queue.submit(1, &submit_info, request.fence);
+      request.submitted_at = TraceClock::now();
+      if (!request.on_complete) {
+        request.submitted.set_value(result);
+      } else if (result == vk::Result::eSuccess) {
+        const std::lock_guard<std::mutex> in_flight_guard(in_flight_lock);
+        in_flight.push_back(std::move(request));
+        added = true;
+      } else {
+        complete(request, result);
+      }
+    }
+  }
+  batch.clear();
+
+  if (added) {
+    in_flight_added.notify_one();
+  }
+}
+
+void SubmissionThread::run_retire(const std::stop_token &stop) {
+  set_trace_thread_name("submission retire");
+  while (true) {
+    vk::Fence oldest;
+    {
+      std::unique_lock<std::mutex> guard(in_flight_lock);
+      in_flight_added.wait(guard, stop, [this] { return !in_flight.empty(); });
+      if (in_flight.empty()) {
+        return;  // stop requested, every upload has completed
+      }
+      oldest = in_flight.front().fence;
+    }
+
+    // the queue executes in submission order, so the oldest fence is the
+    // next to signal; later ones found signaled are retired with it
+    const vk::Result wait_result =
+        device.waitForFences(1, &oldest, vk::True, UINT64_MAX);
+    if (wait_result != vk::Result::eSuccess) {
+#ifndef NDEBUG
+      std::cerr << std::format("Waiting for an upload failed: {}\n",
+                               vk::to_string(wait_result));
+#endif
+    }
+    // e.g. a lost device, the fences would never signal
+    retire_completed(wait_result);
+  }
+}
+
+void SubmissionThread::retire_completed(vk::Result wait_result) {
+  std::vector<Request> completed;
+  {
+    const std::lock_guard<std::mutex> guard(in_flight_lock);
+    for (auto request = in_flight.begin(); request != in_flight.end();) {
+      if (wait_result == vk::Result::eSuccess &&
+          device.getFenceStatus(request->fence) != vk::Result::eSuccess) {
+        ++request;
+        continue;
+      }
+      completed.push_back(std::move(*request));
+      request = in_flight.erase(request);
+    }
+  }
+
+  const TraceClock::time_point now = TraceClock::now();
+  for (Request &request : completed) {
+    if (tracing()) {
+      // submit to the fence being seen
+      trace_event("upload", TraceCategory::GPU, request.submitted_at, now);
+    }
+    complete(request, wait_result);
+  }
+}
+
+void SubmissionThread::complete(Request &request, vk::Result result) {
+  device.destroyCommandPool(request.command_pool);
+  release_fence(request.fence);
+  request.on_complete(result);
+}
+
+vk::Fence SubmissionThread::acquire_fence() {
+  const std::lock_guard<std::mutex> guard(fence_lock);
+  if (!free_fences.empty()) {
+    const vk::Fence fence = free_fences.back();
+    free_fences.pop_back();
+    return fence;
+  }
+
+  // unsignaled, unlike the frame fences
+  const vk::Fence fence = device.createFence(vk::FenceCreateInfo{});
+  fences.push_back(fence);
+  return fence;
+}
+
+void SubmissionThread::release_fence(vk::Fence fence) {
+  [[maybe_unused]] const vk::Result result = device.resetFences(1, &fence);
+  const std::lock_guard<std::mutex> guard(fence_lock);
+  free_fences.push_back(fence);
+}
+}  // namespace ice_threading
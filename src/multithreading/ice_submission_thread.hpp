@@ -0,0 +1,134 @@
+#ifndef ICE_SUBMISSION_THREAD_HPP
+#define ICE_SUBMISSION_THREAD_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <vector>
+
+#include "../config.hpp"
+#include "ice_task.hpp"
+
+namespace ice_threading {
+
+/**
+ * Owns submissions to a vk::Queue, which Vulkan requires to be externally
+ * synchronized. Threads hand their recorded command buffers over and wait on
+ * a fence of their own, so uploads from several workers stay in flight at
+ * the same time instead of each one idling the whole queue.
+ * Coroutines submit asynchronously instead and are resumed once their fence
+ * signals, see gpu_submit. A second thread retires those: it sleeps until
+ * something is in flight, then blocks on the fence of the oldest
+ * submission.
+ * Only one queue can be owned at a time.
+ */
+class SubmissionThread {
+ public:
+  // Command pool and buffer of one asynchronous submission. The pool belongs
+  // to a single recording, so no lock is needed, and is destroyed once the
+  // GPU executed it.
+  struct TransientCommands {
+    vk::CommandPool command_pool;
+    vk::CommandBuffer command_buffer;
+  };
+  using Completion = InlineFunction<void(vk::Result)>;
+
+  SubmissionThread(vk::Device device, vk::Queue queue,
+                   uint32_t queue_family_index);
+  ~SubmissionThread();
+
+  SubmissionThread(const SubmissionThread &) = delete;
+  SubmissionThread &operator=(const SubmissionThread &) = delete;
+
+  // Submits a recorded command buffer and blocks the calling thread until
+  // the GPU has executed it. Thread safe.
+  vk::Result submit_and_wait(vk::CommandBuffer command_buffer);
+
+  // A fresh pool and primary command buffer for submit_async. Thread safe.
+  [[nodiscard]] TransientCommands make_transient_commands();
+
+  // Submits recorded commands without waiting, on_complete is called on one
+  // of the threads of this class once the GPU executed them or the submit
+  // failed.
+  void submit_async(TransientCommands commands, Completion on_complete);
+
+  // Exclusive access to the queue for submissions made elsewhere, e.g. the
+  // frame submit, present and device wait idle.
+  [[nodiscard]] std::unique_lock<std::mutex> lock_queue() {
+    return std::unique_lock<std::mutex>(queue_lock);
+  }
+
+  // The submission thread owning queue, nullptr if there is none.
+  [[nodiscard]] static SubmissionThread *owner_of(vk::Queue queue);
+
+ private:
+  struct Request {
+    vk::CommandBuffer command_buffer;
+    vk::Fence fence;
+    std::promise<vk::Result> submitted;
+    // only set for submit_async
+    vk::CommandPool command_pool;
+    Completion on_complete;
+    TraceClock::time_point submitted_at;
+  };
+
+  void run(const std::stop_token &stop);
+  void submit(std::vector<Request> &batch);
+  void run_retire(const std::stop_token &stop);
+  // completes the requests whose fence signaled, or all of them with
+  // wait_result if waiting failed
+  void retire_completed(vk::Result wait_result);
+  void complete(Request &request, vk::Result result);
+  vk::Fence acquire_fence();
+  void release_fence(vk::Fence fence);
+
+  vk::Device device;
+  vk::Queue queue;
+  uint32_t queue_family_index;
+  std::mutex queue_lock;
+
+  std::vector<Request> requests;
+  std::mutex request_lock;
+  std::condition_variable_any pending;
+
+  // asynchronous submissions whose fence has not signaled yet, oldest first
+  std::deque<Request> in_flight;
+  std::mutex in_flight_lock;
+  std::condition_variable_any in_flight_added;
+
+  // fences are reused, one is in use per waiting thread
+  std::vector<vk::Fence> fences;
+  std::vector<vk::Fence> free_fences;
+  std::mutex fence_lock;
+
+  // last, start once everything else is constructed
+  std::jthread retire_thread;
+  std::jthread thread;
+};
+
+// co_await gpu_submit(submission, scheduler, commands): submits the recorded
+// commands and resumes on the scheduler once the GPU executed them.
+inline auto gpu_submit(SubmissionThread &submission, Scheduler &scheduler,
+                       SubmissionThread::TransientCommands commands) {
+  struct Awaiter {
+    SubmissionThread &submission;
+    Scheduler &scheduler;
+    SubmissionThread::TransientCommands commands;
+    vk::Result result = vk::Result::eSuccess;
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      const JobPriority priority = Scheduler::current_priority();
+      submission.submit_async(
+          commands, [this, handle, priority](vk::Result submit_result) {
+            result = submit_result;
+            resume_on(scheduler, handle, priority);
+          });
+    }
+    [[nodiscard]] vk::Result await_resume() const noexcept { return result; }
+  };
+  return Awaiter{submission, scheduler, commands};
+}
+}  // namespace ice_threading
+
+#endif  // ICE_SUBMISSION_THREAD_HPP
@@ -0,0 +1,302 @@
+#ifndef ICE_TASK_HPP
+#define ICE_TASK_HPP
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "ice_inline_function.hpp"
+#include "ice_scheduler.hpp"
+
+namespace ice_threading {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+// Where a finished task goes next: the awaiting coroutine, or a callback for
+// tasks started from plain code
+struct TaskPromiseBase {
+  std::coroutine_handle<> continuation;
+  InlineFunction<void()> on_complete;
+  std::exception_ptr exception;
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  struct FinalAwaiter {
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      TaskPromiseBase &promise = handle.promise();
+      if (promise.on_complete) {
+        // may destroy this frame, so move the callback out first
+        InlineFunction<void()> on_complete = std::move(promise.on_complete);
+        on_complete();
+        return std::noop_coroutine();
+      }
+      return promise.continuation ? promise.continuation
+                                  : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() noexcept {
+    exception = std::current_exception();
+  }
+
+  void rethrow_if_failed() const {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object() noexcept;
+  void return_value(T result) { value.emplace(std::move(result)); }
+  T result() {
+    rethrow_if_failed();
+    return std::move(*value);
+  }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void result() const { rethrow_if_failed(); }
+};
+}  // namespace detail
+
+/**
+ * Lazily started coroutine. co_await-ing a task runs it on the awaiting
+ * thread and resumes the awaiter once it completed (exceptions propagate).
+ * Suspending on the awaitables below frees the thread: the coroutine is
+ * resumed later by a ResumeJob on the scheduler, so a few workers can keep
+ * many file reads and uploads in flight.
+ */
+template <typename T>
+class [[nodiscard]] Task {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+
+  Task() = default;
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+  Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      destroy();
+      handle = std::exchange(other.handle, {});
+    }
+    return *this;
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task() { destroy(); }
+
+  [[nodiscard]] bool done() const { return !handle || handle.done(); }
+
+  // Runs the task from plain code, on_complete is called once it finished.
+  void start(InlineFunction<void()> on_complete) {
+    handle.promise().on_complete = std::move(on_complete);
+    handle.resume();
+  }
+
+  // The task's result, rethrowing its exception. Only once done().
+  decltype(auto) result() { return handle.promise().result(); }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      [[nodiscard]] bool await_ready() const noexcept {
+        return !handle || handle.done();
+      }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+      decltype(auto) await_resume() { return handle.promise().result(); }
+    };
+    return Awaiter{handle};
+  }
+
+ private:
+  void destroy() {
+    if (handle) {
+      handle.destroy();
+      handle = {};
+    }
+  }
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail {
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>{
+      std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+}  // namespace detail
+
+// Resumes a suspended coroutine on whichever thread runs the job. The frame
+// belongs to the Task (ultimately the TaskJob) that started it: a ResumeJob
+// dropped without running, e.g. by ~Scheduler, leaves it to that owner.
+class ResumeJob : public Job {
+ public:
+  explicit ResumeJob(std::coroutine_handle<> handle) : handle(handle) {
+    trace_name = "resume";
+  }
+
+  // NOLINTBEGIN (misc-unused-parameters)
+  void execute(vk::CommandBuffer command_buffer, vk::Queue queue) final {
+    handle.resume();
+  }
+  // NOLINTEND (misc-unused-parameters)
+
+ private:
+  std::coroutine_handle<> handle;
+};
+
+// Queue a resumption of handle, by default at the priority of the calling
+// job.
+inline void resume_on(
+    Scheduler &scheduler, std::coroutine_handle<> handle,
+    JobPriority priority = Scheduler::current_priority()) {
+  auto *job = new ResumeJob(handle);
+  job->priority = priority;
+  scheduler.submit(job);
+}
+
+// co_await schedule(scheduler): continue on one of the scheduler's threads.
+inline auto schedule(Scheduler &scheduler) {
+  struct Awaiter {
+    Scheduler &scheduler;
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const {
+      resume_on(scheduler, handle);
+    }
+    void await_resume() const noexcept {}
+  };
+  return Awaiter{scheduler};
+}
+
+/**
+ * co_await when_all(scheduler, std::move(tasks)): starts every task as its
+ * own job so they run in parallel, and resumes once all of them completed.
+ * The first exception among them is rethrown.
+ */
+inline auto when_all(Scheduler &scheduler, std::vector<Task<>> tasks) {
+  class Awaiter {
+   public:
+    Awaiter(Scheduler &scheduler, std::vector<Task<>> tasks)
+        : scheduler(scheduler), tasks(std::move(tasks)) {}
+
+    [[nodiscard]] bool await_ready() const noexcept { return tasks.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      waiting = handle;
+      // one extra count, so no task can resume us before all are started
+      remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+      for (Task<> &task : tasks) {
+        Task<> *started = &task;
+        auto *job = new StartJob(
+            [this, started](vk::CommandBuffer, vk::Queue) {
+              started->start([this] {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                  resume_on(scheduler, waiting);
+                }
+              });
+            });
+        job->priority = Scheduler::current_priority();
+        scheduler.submit(job);
+      }
+      // false resumes right away when everything already finished
+      return remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() {
+      for (Task<> &task : tasks) {
+        task.result();
+      }
+    }
+
+   private:
+    class StartJob : public Job {
+     public:
+      using Function = InlineFunction<void(vk::CommandBuffer, vk::Queue)>;
+      explicit StartJob(Function function) : function(std::move(function)) {
+        trace_name = "when_all";
+      }
+      void execute(vk::CommandBuffer command_buffer, vk::Queue queue) final {
+        function(command_buffer, queue);
+      }
+
+     private:
+      Function function;
+    };
+
+    Scheduler &scheduler;
+    std::vector<Task<>> tasks;
+    std::atomic<std::size_t> remaining{0};
+    std::coroutine_handle<> waiting;
+  };
+  return Awaiter{scheduler, std::move(tasks)};
+}
+
+/**
+ * Runs a task as a node of the job graph: execute() starts it and the job
+ * only finishes, releasing its continuations and counter, once the task
+ * completed. An exception escaping the task is logged (under the job's
+ * trace_name) and the job still finishes.
+ */
+class TaskJob : public Job {
+ public:
+  TaskJob(Scheduler &scheduler, Task<> task)
+      : scheduler(scheduler), task(std::move(task)) {
+    trace_name = "TaskJob";
+  }
+
+  // NOLINTBEGIN (misc-unused-parameters)
+  void execute(vk::CommandBuffer command_buffer, vk::Queue queue) final {
+    scheduler.defer_finish(this);
+    task.start([this] {
+      // nothing awaits the task, so its failure is reported here, in every
+      // build: otherwise e.g. a texture silently stays the placeholder
+      try {
+        task.result();
+      } catch (const std::exception &err) {
+        std::cerr << std::format("{} failed: {}\n", trace_name, err.what());
+      } catch (...) {
+        std::cerr << std::format("{} failed\n", trace_name);
+      }
+      // deletes this job and the task's frame
+      scheduler.finish_deferred(this);
+    });
+  }
+  // NOLINTEND (misc-unused-parameters)
+
+ private:
+  Scheduler &scheduler;
+  Task<> task;
+};
+}  // namespace ice_threading
+
+#endif  // ICE_TASK_HPP
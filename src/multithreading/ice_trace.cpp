@@ -0,0 +1,189 @@
+#include "ice_trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ice_threading {
+
+namespace detail {
+std::atomic<bool> tracing_enabled{false};
+}  // namespace detail
+
+namespace {
+constexpr std::size_t EVENTS_PER_THREAD = std::size_t{1} << 14;
+
+constexpr std::array<const char *, 6> CATEGORY_NAMES = {
+    "job", "wait", "submit", "gpu", "io", "frame"};
+
+struct TraceEvent {
+  const char *name;
+  std::int64_t begin_ns;
+  std::int64_t end_ns;
+  TraceCategory category;
+};
+
+// Events and written are written only by its thread, read by the exporter
+struct TraceBuffer {
+  std::array<TraceEvent, EVENTS_PER_THREAD> events;
+  std::atomic<std::uint64_t> written{0};
+  // events before this one were cleared, guarded by the registry lock. The
+  // owner keeps counting, so clearing never races with its writes.
+  std::uint64_t cleared{0};
+  std::string thread_name;  // guarded by the registry lock
+};
+
+// Owns the buffers, which outlive their threads so they can be exported
+struct TraceRegistry {
+  std::mutex lock;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+  const TraceClock::time_point origin = TraceClock::now();
+};
+
+TraceRegistry &registry() {
+  static TraceRegistry instance;
+  return instance;
+}
+
+// The ring is only allocated by the thread's first event while tracing, so
+// naming a thread that never records costs a short string
+thread_local TraceBuffer *thread_buffer = nullptr;
+thread_local std::string thread_name;
+
+TraceBuffer &local_buffer() {
+  if (thread_buffer == nullptr) {
+    TraceRegistry &shared = registry();
+    const std::lock_guard<std::mutex> guard(shared.lock);
+    shared.buffers.push_back(std::make_unique<TraceBuffer>());
+    thread_buffer = shared.buffers.back().get();
+    thread_buffer->thread_name =
+        thread_name.empty()
+            ? std::format("thread {}", shared.buffers.size() - 1)
+            : thread_name;
+  }
+  return *thread_buffer;
+}
+
+std::int64_t since_origin(TraceClock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time - registry().origin)
+      .count();
+}
+
+std::string escape_json(const std::string &text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+    }
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+}  // namespace
+
+void start_tracing() {
+  detail::tracing_enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop_tracing() {
+  detail::tracing_enabled.store(false, std::memory_order_relaxed);
+}
+
+void set_trace_thread_name(std::string name) {
+  thread_name = std::move(name);
+  if (thread_buffer != nullptr) {
+    const std::lock_guard<std::mutex> guard(registry().lock);
+    thread_buffer->thread_name = thread_name;
+  }
+}
+
+void trace_event(const char *name, TraceCategory category,
+                 TraceClock::time_point begin, TraceClock::time_point end) {
+  if (!tracing()) {
+    return;
+  }
+  TraceBuffer &buffer = local_buffer();
+  const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+  buffer.events[index % EVENTS_PER_THREAD] = {.name = name,
+                                              .begin_ns = since_origin(begin),
+                                              .end_ns = since_origin(end),
+                                              .category = category};
+  buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void clear_trace() {
+  TraceRegistry &shared = registry();
+  const std::lock_guard<std::mutex> guard(shared.lock);
+  for (const auto &buffer : shared.buffers) {
+    buffer->cleared = buffer->written.load(std::memory_order_acquire);
+  }
+}
+
+bool write_chrome_trace(const std::string &path) {
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  TraceRegistry &shared = registry();
+  const std::lock_guard<std::mutex> guard(shared.lock);
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  const auto separator = [&first] {
+    const char *text = first ? "" : ",\n";
+    first = false;
+    return text;
+  };
+
+  std::uint64_t gpu_id = 0;
+  for (std::size_t tid = 0; tid < shared.buffers.size(); ++tid) {
+    const TraceBuffer &buffer = *shared.buffers[tid];
+    file << std::format(
+        "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+        "\"args\":{{\"name\":\"{}\"}}}}",
+        separator(), tid, escape_json(buffer.thread_name));
+
+    const std::uint64_t written =
+        buffer.written.load(std::memory_order_acquire);
+    const std::uint64_t oldest = std::max(
+        buffer.cleared,
+        written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0);
+    for (std::uint64_t i = oldest; i < written; ++i) {
+      const TraceEvent &event = buffer.events[i % EVENTS_PER_THREAD];
+      const std::string name = escape_json(event.name);
+      const char *category =
+          CATEGORY_NAMES[static_cast<std::size_t>(event.category)];
+      // timestamps are in microseconds
+      const double begin_us = static_cast<double>(event.begin_ns) / 1000.0;
+      const double end_us = static_cast<double>(event.end_ns) / 1000.0;
+
+      if (event.category == TraceCategory::GPU) {
+        // in-flight GPU work overlaps, async events get a lane each
+        file << std::format(
+            "{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"b\",\"id\":{},"
+            "\"ts\":{:.3f},\"pid\":1,\"tid\":{}}}",
+            separator(), name, category, gpu_id, begin_us, tid);
+        file << std::format(
+            "{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"e\",\"id\":{},"
+            "\"ts\":{:.3f},\"pid\":1,\"tid\":{}}}",
+            separator(), name, category, gpu_id, end_us, tid);
+        ++gpu_id;
+        continue;
+      }
+      file << std::format(
+          "{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+          "\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+          separator(), name, category, begin_us, end_us - begin_us, tid);
+    }
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+}  // namespace ice_threading
@@ -0,0 +1,81 @@
+#ifndef ICE_TRACE_HPP
+#define ICE_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ice_threading {
+
+enum class TraceCategory : std::uint8_t { JOB, WAIT, SUBMIT, GPU, IO, FRAME };
+
+using TraceClock = std::chrono::steady_clock;
+
+namespace detail {
+extern std::atomic<bool> tracing_enabled;
+}  // namespace detail
+
+/**
+ * Timeline of what every thread was doing, exported as Chrome trace JSON
+ * (chrome://tracing, ui.perfetto.dev).
+ * Each thread records into a ring buffer of its own, so recording takes no
+ * lock and never allocates once the buffer exists (from the thread's first
+ * event on); when a buffer is full the oldest events are overwritten.
+ * Tracing is off until start_tracing(), and costs a relaxed load per event
+ * site while it is.
+ */
+[[nodiscard]] inline bool tracing() {
+  return detail::tracing_enabled.load(std::memory_order_relaxed);
+}
+void start_tracing();
+void stop_tracing();
+
+// Name shown for the calling thread's track. Threads only get a track (and
+// its ring buffer) once they record an event.
+void set_trace_thread_name(std::string name);
+
+// Records a completed event on the calling thread, unless tracing is off.
+// name must be a string literal, or outlive the next export. GPU events may
+// overlap each other.
+void trace_event(const char *name, TraceCategory category,
+                 TraceClock::time_point begin, TraceClock::time_point end);
+
+// Drops every event recorded so far, e.g. after exporting the startup. Safe
+// while other threads record: their later events are kept.
+void clear_trace();
+
+/**
+ * Writes the recorded events as Chrome trace JSON, returns false if the
+ * file could not be written. Export while the traced threads are idle (or
+ * after stop_tracing()): events recorded during the export may be torn.
+ */
+bool write_chrome_trace(const std::string &path);
+
+// Records the enclosing scope as one event, if tracing when constructed.
+class TraceScope {
+ public:
+  TraceScope(const char *name, TraceCategory category)
+      : name(name), category(category), enabled(tracing()) {
+    if (enabled) {
+      begin = TraceClock::now();
+    }
+  }
+  ~TraceScope() {
+    if (enabled) {
+      trace_event(name, category, begin, TraceClock::now());
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  const char *name;
+  TraceCategory category;
+  bool enabled;
+  TraceClock::time_point begin;
+};
+}  // namespace ice_threading
+
+#endif  // ICE_TRACE_HPP
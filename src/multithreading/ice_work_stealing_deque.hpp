@@ -0,0 +1,147 @@
+#ifndef ICE_WORK_STEALING_DEQUE_HPP
+#define ICE_WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ice_threading {
+
+/**
+ * Chase-Lev work-stealing deque of pointers.
+ * The owning thread pushes and pops at the bottom (LIFO, cache friendly),
+ * any other thread may steal from the top (FIFO). push/pop/steal are O(1)
+ * and lock-free. The ring grows when full; retired rings are kept alive until
+ * the deque is destroyed since a thief may still be reading from them.
+ * Memory orderings follow Le et al., "Correct and Efficient Work-Stealing for
+ * Weak Memory Models" (PPoPP 2013).
+ */
+template <typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(std::size_t capacity = 1024) {
+    std::size_t rounded = 1;
+    while (rounded < capacity) {
+      rounded <<= 1;
+    }
+    rings.push_back(std::make_unique<Ring>(rounded));
+    ring.store(rings.back().get(), std::memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // Owner only.
+  void push(T *item) {
+    const std::int64_t b = bottom.load(std::memory_order_relaxed);
+    const std::int64_t t = top.load(std::memory_order_acquire);
+    Ring *current = ring.load(std::memory_order_relaxed);
+
+    if (b - t > static_cast<std::int64_t>(current->capacity) - 1) {
+      current = grow(current, b, t);
+    }
+
+    current->put(b, item);
+    // a release store rather than fence + relaxed store: the same ordering,
+    // and thread sanitizer sees the publication
+    bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only. Returns nullptr when empty.
+  T *pop() {
+    const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Ring *current = ring.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      // empty
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    T *item = current->get(b);
+    if (t == b) {
+      // last item, race against thieves
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any thread. Returns nullptr when empty or when it lost a race.
+  T *steal() {
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const std::int64_t b = bottom.load(std::memory_order_acquire);
+
+    if (t >= b) {
+      return nullptr;
+    }
+
+    Ring *current = ring.load(std::memory_order_acquire);
+    T *item = current->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  // Approximate when called from a thief.
+  [[nodiscard]] bool empty() const {
+    const std::int64_t b = bottom.load(std::memory_order_relaxed);
+    const std::int64_t t = top.load(std::memory_order_relaxed);
+    return b <= t;
+  }
+
+ private:
+  struct Ring {
+    explicit Ring(std::size_t capacity)
+        : capacity(capacity),
+          mask(capacity - 1),
+          items(std::make_unique<std::atomic<T *>[]>(capacity)) {}
+
+    T *get(std::int64_t i) const {
+      return items[static_cast<std::size_t>(i) & mask].load(
+          std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t i, T *item) {
+      items[static_cast<std::size_t>(i) & mask].store(
+          item, std::memory_order_relaxed);
+    }
+
+    std::size_t capacity;
+    std::size_t mask;
+    std::unique_ptr<std::atomic<T *>[]> items;
+  };
+
+  Ring *grow(Ring *old_ring, std::int64_t b, std::int64_t t) {
+    rings.push_back(std::make_unique<Ring>(old_ring->capacity * 2));
+    Ring *new_ring = rings.back().get();
+    for (std::int64_t i = t; i < b; ++i) {
+      new_ring->put(i, old_ring->get(i));
+    }
+    ring.store(new_ring, std::memory_order_release);
+    return new_ring;
+  }
+
+  // top and bottom are written by different threads, keep them on separate
+  // cache lines
+  alignas(64) std::atomic<std::int64_t> top{0};
+  alignas(64) std::atomic<std::int64_t> bottom{0};
+  alignas(64) std::atomic<Ring *> ring{nullptr};
+
+  // owner only, every ring ever used (the last one is current)
+  std::vector<std::unique_ptr<Ring>> rings;
+};
+
+}  // namespace ice_threading
+
+#endif  // ICE_WORK_STEALING_DEQUE_HPP
@@ -1,48 +1,36 @@
 #include "ice_worker_threads.hpp"
 
-#include "multithreading/ice_jobs.hpp"
 namespace ice_threading {
 
-WorkerThread::WorkerThread(WorkQueue &work_queue, bool &done,
+WorkerThread::WorkerThread(Scheduler &scheduler, std::size_t slot,
                            vk::CommandBuffer command_buffer, vk::Queue queue)
-    : work_queue(work_queue),
-      done(done),
+    : scheduler(scheduler),
+      slot(slot),
       command_buffer(command_buffer),
       queue(queue) {}
 
 void WorkerThread::operator()() {
-  work_queue.lock.lock();
+  scheduler.register_thread(slot, {.command_buffer = command_buffer,
+                                   .queue = queue});
+  set_trace_thread_name(std::format("worker {}", slot));
 #ifndef NDEBUG
-  std::cout << "----    Thread is ready to go.    ----" << std::endl;
+  std::cout << std::format("----    Thread {} is ready to go.    ----\n",
+                           slot);
 #endif
-  work_queue.lock.unlock();
 
-  while (!done) {
-    if (!work_queue.lock.try_lock()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(200));
-      continue;
-    }
-
-    if (work_queue.done()) {
-      work_queue.lock.unlock();
-      continue;
-    }
-
-    Job *pending_job = work_queue.get_next();
+  while (!scheduler.stopped()) {
+    const std::uint32_t epoch = scheduler.work_epoch();
+    Job *pending_job = scheduler.get_next();
 
     if (pending_job == nullptr) {
-      work_queue.lock.unlock();
+      // park until something is submitted
+      scheduler.wait_for_work(epoch);
       continue;
     }
-#ifndef NDEBUG
-    std::cout << "----    Working on a job.    ----" << std::endl;
-#endif
-    pending_job->status = JobStatus::IN_PROGRESS;
-    work_queue.lock.unlock();
-    pending_job->execute(command_buffer, queue);
+    scheduler.run(pending_job);
   }
 #ifndef NDEBUG
-  std::cout << "----    Thread done.    ----" << std::endl;
+  std::cout << std::format("----    Thread {} done.    ----\n", slot);
 #endif
 }
 }  // namespace ice_threading
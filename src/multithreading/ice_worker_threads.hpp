@@ -1,16 +1,16 @@
 #ifndef ICE_WORKER_THREADS_HPP
 #define ICE_WORKER_THREADS_HPP
 
-#include "ice_jobs.hpp"
+#include "ice_scheduler.hpp"
 namespace ice_threading {
 class WorkerThread {
  public:
-  bool &done;
-  WorkQueue &work_queue;
+  Scheduler &scheduler;
+  std::size_t slot;
   vk::CommandBuffer command_buffer;
   vk::Queue queue;
 
-  WorkerThread(WorkQueue &work_queue, bool &done,
+  WorkerThread(Scheduler &scheduler, std::size_t slot,
                vk::CommandBuffer command_buffer, vk::Queue queue);
 
   void operator()();
@@ -0,0 +1,246 @@
+#ifndef OBJ_PARSING_HPP
+#define OBJ_PARSING_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// In-place tokenizing of OBJ and MTL text: tokens are views into the file,
+// numbers are read with std::from_chars (locale independent, no copies)
+namespace ice::obj {
+
+// Cuts the next line, without its line break, off the front of text.
+inline std::string_view next_line(std::string_view &text) {
+  const std::size_t end = text.find('\n');
+  const std::string_view line = text.substr(0, end);
+  text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+  return line;
+}
+
+// Cuts the next token off the front of line, empty once the line is used
+// up. The '\r' of CRLF files counts as whitespace.
+inline std::string_view next_token(std::string_view &line) {
+  constexpr std::string_view WHITESPACE = " \t\r";
+  const std::size_t begin = line.find_first_not_of(WHITESPACE);
+  if (begin == std::string_view::npos) {
+    line = {};
+    return {};
+  }
+  line.remove_prefix(begin);
+  const std::size_t end = std::min(line.find_first_of(WHITESPACE), line.size());
+  const std::string_view token = line.substr(0, end);
+  line.remove_prefix(end);
+  return token;
+}
+
+// 0 for malformed or missing numbers
+inline float parse_float(std::string_view token) {
+  // from_chars rejects the leading '+' std::stof accepted
+  if (!token.empty() && token.front() == '+') {
+    token.remove_prefix(1);
+  }
+  float value = 0.0f;
+  std::from_chars(token.data(), token.data() + token.size(), value);
+  return value;
+}
+
+// Reads the next three tokens of line.
+inline glm::vec3 parse_vec3(std::string_view &line) {
+  const float x = parse_float(next_token(line));
+  const float y = parse_float(next_token(line));
+  const float z = parse_float(next_token(line));
+  return {x, y, z};
+}
+
+// Attribute indices of a face corner as written (1 based, negative ones
+// count back from the last element so far), 0 when absent.
+struct CornerIndices {
+  long position{0};
+  long texcoord{0};
+  long normal{0};
+};
+
+// The diffuse colors (Kd) of the materials of an MTL file, in the order the
+// materials first appear.
+struct MaterialColors {
+  std::vector<std::string_view> names;
+  std::vector<glm::vec3> colors;
+  // the file's last Kd, the color of the faces before any usemtl
+  std::optional<glm::vec3> last;
+};
+
+// A material with several Kd keeps its first one, as the loader always did
+// (it stored them with unordered_map::insert). A Kd before any newmtl
+// belongs to the material named "".
+inline MaterialColors read_material_colors(std::string_view text) {
+  MaterialColors materials;
+  std::unordered_set<std::string_view> seen;
+  std::string_view material_name;
+  while (!text.empty()) {
+    std::string_view line = next_line(text);
+    const std::string_view keyword = next_token(line);
+
+    if (keyword == "newmtl") {
+      material_name = next_token(line);
+    } else if (keyword == "Kd") {
+      materials.last = parse_vec3(line);
+      if (seen.insert(material_name).second) {
+        materials.names.push_back(material_name);
+        materials.colors.push_back(*materials.last);
+      }
+    }
+  }
+  return materials;
+}
+
+// Parses v, v/vt, v//vn or v/vt/vn.
+inline CornerIndices parse_corner(std::string_view corner) {
+  CornerIndices indices;
+  for (long *field : {&indices.position, &indices.texcoord, &indices.normal}) {
+    const std::size_t slash = corner.find('/');
+    const std::string_view part = corner.substr(0, slash);
+    std::from_chars(part.data(), part.data() + part.size(), *field);
+    if (slash == std::string_view::npos) {
+      break;
+    }
+    corner.remove_prefix(slash + 1);
+  }
+  return indices;
+}
+
+/**
+ * Identity of a face corner for vertex deduplication, packed into two
+ * words: the 0 based position and texcoord indices, then the normal index,
+ * the material id and which indices are still relative. Absent indices are
+ * NONE. A negative index in the file counts back from the last element read
+ * so far; while a file is parsed in chunks it can only be resolved relative
+ * to the chunk's first element, so its bit stays set until the chunk's
+ * offsets are added. Corners before a chunk's first usemtl have the
+ * INHERITED material until the previous chunks' material is known.
+ */
+struct CornerKey {
+  static constexpr std::uint32_t NONE = 0xFFFFFFFF;
+  static constexpr std::uint32_t INHERITED = (1U << 29) - 1;
+  static constexpr std::uint32_t POSITION = 1, TEXCOORD = 2, NORMAL = 4;
+
+  std::uint64_t indices{0};     // position | texcoord << 32
+  std::uint64_t attributes{0};  // normal | material << 32 | relative << 61
+
+  static CornerKey make(std::uint32_t position, std::uint32_t texcoord,
+                        std::uint32_t normal, std::uint32_t material,
+                        std::uint32_t relative) {
+    return {position | (std::uint64_t{texcoord} << 32),
+            normal | (std::uint64_t{material} << 32) |
+                (std::uint64_t{relative} << 61)};
+  }
+
+  [[nodiscard]] std::uint32_t position() const {
+    return static_cast<std::uint32_t>(indices);
+  }
+  [[nodiscard]] std::uint32_t texcoord() const {
+    return static_cast<std::uint32_t>(indices >> 32);
+  }
+  [[nodiscard]] std::uint32_t normal() const {
+    return static_cast<std::uint32_t>(attributes);
+  }
+  [[nodiscard]] std::uint32_t material() const {
+    return static_cast<std::uint32_t>(attributes >> 32) & INHERITED;
+  }
+  [[nodiscard]] std::uint32_t relative() const {
+    return static_cast<std::uint32_t>(attributes >> 61);
+  }
+
+  bool operator==(const CornerKey &other) const = default;
+};
+
+struct CornerKeyHash {
+  std::size_t operator()(const CornerKey &key) const {
+    // the splitmix64 finalizer, so every bit of both words reaches the low
+    // bits that pick a slot
+    const auto mix = [](std::uint64_t x) {
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+      return x ^ (x >> 31);
+    };
+    return static_cast<std::size_t>(mix(mix(key.indices) ^ key.attributes));
+  }
+};
+
+// counts are the number of positions, texcoords and normals read so far
+// (in the current chunk)
+inline CornerKey resolve_corner(const CornerIndices &indices,
+                                std::size_t position_count,
+                                std::size_t texcoord_count,
+                                std::size_t normal_count,
+                                std::uint32_t material) {
+  std::uint32_t relative = 0;
+  const auto resolve = [&relative](long index, std::size_t count,
+                                   std::uint32_t bit) -> std::uint32_t {
+    if (index > 0) {
+      return static_cast<std::uint32_t>(index - 1);
+    }
+    if (index < 0) {
+      // may go below the chunk's first element, wraps around until the
+      // chunk's offset is added
+      relative |= bit;
+      return static_cast<std::uint32_t>(count) +
+             static_cast<std::uint32_t>(index);
+    }
+    return CornerKey::NONE;
+  };
+  const std::uint32_t position =
+      resolve(indices.position, position_count, CornerKey::POSITION);
+  const std::uint32_t texcoord =
+      resolve(indices.texcoord, texcoord_count, CornerKey::TEXCOORD);
+  const std::uint32_t normal =
+      resolve(indices.normal, normal_count, CornerKey::NORMAL);
+  return CornerKey::make(position, texcoord, normal, material, relative);
+}
+
+// Adds the offsets of a chunk's first elements to its relative indices and
+// replaces an INHERITED material with the one the previous chunks ended on.
+inline CornerKey globalize_corner(const CornerKey &corner,
+                                  std::size_t position_offset,
+                                  std::size_t texcoord_offset,
+                                  std::size_t normal_offset,
+                                  std::uint32_t inherited_material) {
+  const std::uint32_t relative = corner.relative();
+  const auto globalize = [relative](std::uint32_t index, std::size_t offset,
+                                    std::uint32_t bit) -> std::uint32_t {
+    return (relative & bit) != 0 ? index + static_cast<std::uint32_t>(offset)
+                                 : index;
+  };
+  return CornerKey::make(
+      globalize(corner.position(), position_offset, CornerKey::POSITION),
+      globalize(corner.texcoord(), texcoord_offset, CornerKey::TEXCOORD),
+      globalize(corner.normal(), normal_offset, CornerKey::NORMAL),
+      corner.material() == CornerKey::INHERITED ? inherited_material
+                                                : corner.material(),
+      0);
+}
+
+// Splits text into pieces of roughly chunk_size bytes that end on a line
+// break, so no record is cut in two.
+inline std::vector<std::string_view> split_into_chunks(std::string_view text,
+                                                       std::size_t chunk_size) {
+  std::vector<std::string_view> chunks;
+  while (!text.empty()) {
+    std::size_t end = text.size();
+    if (chunk_size < text.size()) {
+      const std::size_t line_break = text.find('\n', chunk_size);
+      end = line_break == std::string_view::npos ? text.size() : line_break + 1;
+    }
+    chunks.push_back(text.substr(0, end));
+    text.remove_prefix(end);
+  }
+  return chunks;
+}
+}  // namespace ice::obj
+
+#endif  // OBJ_PARSING_HPP
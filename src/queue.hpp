@@ -2,6 +2,7 @@
 #define QUEUE_HPP
 
 #include "config.hpp"
+#include "multithreading/ice_submission_thread.hpp"
 
 namespace ice {
 
@@ -44,6 +45,22 @@ inline QueueFamilyIndices find_queue_families(
   }
   return indices;
 }
+
+// Submit a recorded one time command buffer and wait for its completion.
+// Goes through the queue's submission thread when it has one.
+inline vk::Result submit_and_wait(vk::CommandBuffer command_buffer,
+                                  vk::Queue queue) {
+  if (ice_threading::SubmissionThread *owner =
+          ice_threading::SubmissionThread::owner_of(queue)) {
+    return owner->submit_and_wait(command_buffer);
+  }
+
+  const vk::SubmitInfo submit_info{.commandBufferCount = 1,
+                                   .pCommandBuffers = &command_buffer};
+  const vk::Result result = queue.submit(1, &submit_info, nullptr);
+  queue.waitIdle();
+  return result;
+}
 }  // namespace ice
 
 #endif  // QUEUE_HPP
@@ -0,0 +1,130 @@
+#include "staging_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <utility>
+
+namespace ice {
+
+struct StagingAllocator::Block {
+  BufferBundle staging;
+  std::byte *mapped{nullptr};
+  vk::DeviceSize capacity{0};
+  bool in_use{false};
+};
+
+StagingAllocator::Allocation::Allocation(Allocation &&other) noexcept
+    : owner(std::exchange(other.owner, nullptr)),
+      block(std::exchange(other.block, nullptr)),
+      bytes(std::exchange(other.bytes, 0)) {}
+
+StagingAllocator::Allocation &StagingAllocator::Allocation::operator=(
+    Allocation &&other) noexcept {
+  if (this != &other) {
+    reset();
+    owner = std::exchange(other.owner, nullptr);
+    block = std::exchange(other.block, nullptr);
+    bytes = std::exchange(other.bytes, 0);
+  }
+  return *this;
+}
+
+std::byte *StagingAllocator::Allocation::data() const {
+  return block != nullptr ? block->mapped : nullptr;
+}
+
+vk::Buffer StagingAllocator::Allocation::buffer() const {
+  return block != nullptr ? block->staging.buffer : vk::Buffer{};
+}
+
+void StagingAllocator::Allocation::reset() {
+  if (block != nullptr) {
+    owner->release(block);
+  }
+  owner = nullptr;
+  block = nullptr;
+  bytes = 0;
+}
+
+StagingAllocator::StagingAllocator(const StagingAllocatorInput &input)
+    : physical_device(input.physical_device),
+      device(input.logical_device),
+      min_block_size(std::max<vk::DeviceSize>(input.min_block_size, 1)) {}
+
+StagingAllocator::~StagingAllocator() {
+  assert(std::none_of(
+      blocks.begin(), blocks.end(),
+      [](const std::unique_ptr<Block> &block) { return block->in_use; }));
+  trim();
+}
+
+StagingAllocator::Allocation StagingAllocator::allocate(vk::DeviceSize size) {
+  Allocation allocation;
+  allocation.owner = this;
+  allocation.bytes = size;
+  {
+    const std::lock_guard<std::mutex> guard(lock);
+#ifndef NDEBUG
+    ++allocations;
+#endif
+    Block *best = nullptr;
+    for (const std::unique_ptr<Block> &block : blocks) {
+      if (!block->in_use && block->capacity >= size &&
+          (best == nullptr || block->capacity < best->capacity)) {
+        best = block.get();
+      }
+    }
+    if (best != nullptr) {
+#ifndef NDEBUG
+      ++reuses;
+#endif
+      best->in_use = true;
+      allocation.block = best;
+      return allocation;
+    }
+  }
+
+  // nothing fits, the new buffer is made outside the lock
+  auto block = std::make_unique<Block>();
+  block->capacity = std::max(min_block_size, std::bit_ceil(size));
+  block->staging =
+      create_buffer({.size = block->capacity,
+                     .usage = vk::BufferUsageFlagBits::eTransferSrc,
+                     .logical_device = device,
+                     .physical_device = physical_device});
+  // host coherent, stays mapped for the lifetime of the block
+  block->mapped = static_cast<std::byte *>(
+      device.mapMemory(block->staging.buffer_memory, 0, block->capacity));
+  block->in_use = true;
+  allocation.block = block.get();
+
+  const std::lock_guard<std::mutex> guard(lock);
+  blocks.push_back(std::move(block));
+  return allocation;
+}
+
+void StagingAllocator::release(Block *block) {
+  const std::lock_guard<std::mutex> guard(lock);
+  block->in_use = false;
+}
+
+void StagingAllocator::trim() {
+  const std::lock_guard<std::mutex> guard(lock);
+#ifndef NDEBUG
+  if (allocations > 0) {
+    std::cout << std::format(
+        "Staging allocator: {} allocations, {} reused a buffer\n", allocations,
+        reuses);
+  }
+#endif
+  std::erase_if(blocks, [this](const std::unique_ptr<Block> &block) {
+    if (block->in_use) {
+      return false;
+    }
+    device.unmapMemory(block->staging.buffer_memory);
+    destroy_buffer(device, block->staging);
+    return true;
+  });
+}
+}  // namespace ice
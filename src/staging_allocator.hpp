@@ -0,0 +1,82 @@
+#ifndef STAGING_ALLOCATOR_HPP
+#define STAGING_ALLOCATOR_HPP
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "data_buffers.hpp"
+
+namespace ice {
+
+struct StagingAllocatorInput {
+  vk::PhysicalDevice physical_device;
+  vk::Device logical_device;
+  // smallest buffer made, larger ones are rounded up to a power of two so
+  // they fit the next uploads of a similar size
+  vk::DeviceSize min_block_size{vk::DeviceSize{1} << 20};
+};
+
+/**
+ * Hands out persistently mapped staging buffers, so decoders write pixels
+ * straight into memory the GPU copies from. Buffers go back to the
+ * allocator once their upload completed and are reused by the next uploads
+ * that fit, instead of being created and destroyed per upload. Thread safe.
+ */
+class StagingAllocator {
+ public:
+  struct Block;
+
+  // Mapped staging memory, returned to its allocator when destroyed (or
+  // reset). The copies reading it must have completed by then.
+  class Allocation {
+   public:
+    Allocation() = default;
+    ~Allocation() { reset(); }
+    Allocation(Allocation &&other) noexcept;
+    Allocation &operator=(Allocation &&other) noexcept;
+    Allocation(const Allocation &) = delete;
+    Allocation &operator=(const Allocation &) = delete;
+
+    [[nodiscard]] std::byte *data() const;
+    [[nodiscard]] vk::Buffer buffer() const;
+    [[nodiscard]] vk::DeviceSize size() const { return bytes; }
+    explicit operator bool() const { return block != nullptr; }
+
+    void reset();
+
+   private:
+    friend class StagingAllocator;
+    StagingAllocator *owner{nullptr};
+    Block *block{nullptr};
+    vk::DeviceSize bytes{0};
+  };
+
+  explicit StagingAllocator(const StagingAllocatorInput &input);
+  ~StagingAllocator();  // every allocation must have been returned
+
+  StagingAllocator(const StagingAllocator &) = delete;
+  StagingAllocator &operator=(const StagingAllocator &) = delete;
+
+  // At least size bytes, from the smallest idle buffer they fit in.
+  Allocation allocate(vk::DeviceSize size);
+
+  // Destroys the idle buffers, e.g. once the assets are loaded.
+  void trim();
+
+ private:
+  void release(Block *block);
+
+  vk::PhysicalDevice physical_device;
+  vk::Device device;
+  vk::DeviceSize min_block_size;
+
+  std::mutex lock;
+  std::vector<std::unique_ptr<Block>> blocks;
+#ifndef NDEBUG
+  std::size_t allocations{0}, reuses{0};
+#endif
+};
+}  // namespace ice
+
+#endif  // STAGING_ALLOCATOR_HPP
@@ -0,0 +1,89 @@
+#include "staging_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ice {
+
+StagingRing::StagingRing(const StagingRingInput &input)
+    : device(input.logical_device),
+      submission(*input.submission),
+      slot_size(input.slot_size),
+      slots(std::max<std::size_t>(input.slot_count, 1)) {
+  const BufferCreationInput buffer_input = {
+      .size = slot_size,
+      .usage = vk::BufferUsageFlagBits::eTransferSrc,
+      .logical_device = input.logical_device,
+      .physical_device = input.physical_device};
+  for (Slot &slot : slots) {
+    slot.staging = create_buffer(buffer_input);
+    // host coherent, stays mapped for the lifetime of the ring
+    slot.mapped = static_cast<std::byte *>(
+        device.mapMemory(slot.staging.buffer_memory, 0, slot_size));
+  }
+}
+
+StagingRing::~StagingRing() {
+  wait_idle();
+  for (Slot &slot : slots) {
+    device.unmapMemory(slot.staging.buffer_memory);
+    destroy_buffer(device, slot.staging);
+  }
+}
+
+void StagingRing::upload(std::span<const std::byte> bytes, vk::Buffer buffer,
+                         vk::DeviceSize offset) {
+  while (!bytes.empty()) {
+    const std::size_t size = std::min<std::size_t>(
+        bytes.size(), static_cast<std::size_t>(slot_size));
+    const std::size_t index = acquire_slot();
+    Slot &slot = slots[index];
+    std::memcpy(slot.mapped, bytes.data(), size);
+
+    const ice_threading::SubmissionThread::TransientCommands commands =
+        submission.make_transient_commands();
+    commands.command_buffer.begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    const vk::BufferCopy copy_region{
+        .srcOffset = 0, .dstOffset = offset, .size = size};
+    commands.command_buffer.copyBuffer(slot.staging.buffer, buffer, 1,
+                                       &copy_region);
+    commands.command_buffer.end();
+
+    submission.submit_async(commands, [this, index](vk::Result result) {
+      {
+        const std::lock_guard<std::mutex> guard(lock);
+        slots[index].busy = false;
+        failed = failed || result != vk::Result::eSuccess;
+      }
+      slot_freed.notify_all();
+    });
+
+    bytes = bytes.subspan(size);
+    offset += size;
+  }
+}
+
+bool StagingRing::wait_idle() {
+  std::unique_lock<std::mutex> guard(lock);
+  slot_freed.wait(guard, [this] {
+    return std::none_of(slots.begin(), slots.end(),
+                        [](const Slot &slot) { return slot.busy; });
+  });
+  return !failed;
+}
+
+std::size_t StagingRing::acquire_slot() {
+  std::unique_lock<std::mutex> guard(lock);
+  std::size_t index = slots.size();
+  slot_freed.wait(guard, [this, &index] {
+    const auto free_slot =
+        std::find_if(slots.begin(), slots.end(),
+                     [](const Slot &slot) { return !slot.busy; });
+    index = static_cast<std::size_t>(free_slot - slots.begin());
+    return free_slot != slots.end();
+  });
+  slots[index].busy = true;
+  return index;
+}
+}  // namespace ice
@@ -0,0 +1,65 @@
+#ifndef STAGING_RING_HPP
+#define STAGING_RING_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "data_buffers.hpp"
+#include "multithreading/ice_submission_thread.hpp"
+
+namespace ice {
+
+struct StagingRingInput {
+  vk::PhysicalDevice physical_device;
+  vk::Device logical_device;
+  ice_threading::SubmissionThread *submission;
+  vk::DeviceSize slot_size;
+  std::size_t slot_count;
+};
+
+/**
+ * Fixed set of persistently mapped staging buffers that uploads of any size
+ * stream through, so the host memory they take is bounded by
+ * slot_size * slot_count. Every slot's copy is submitted on its own through
+ * the submission thread, and a slot is reused once the GPU executed it;
+ * upload() blocks while every slot is in flight.
+ */
+class StagingRing {
+ public:
+  explicit StagingRing(const StagingRingInput &input);
+  ~StagingRing();  // waits for the copies in flight
+
+  StagingRing(const StagingRing &) = delete;
+  StagingRing &operator=(const StagingRing &) = delete;
+
+  // Copies bytes into buffer at offset, in slot sized pieces. The data can be
+  // reused as soon as this returns.
+  void upload(std::span<const std::byte> bytes, vk::Buffer buffer,
+              vk::DeviceSize offset);
+
+  // Blocks until every copy completed, false if one of them failed.
+  bool wait_idle();
+
+ private:
+  struct Slot {
+    BufferBundle staging;
+    std::byte *mapped{nullptr};
+    bool busy{false};
+  };
+
+  std::size_t acquire_slot();
+
+  vk::Device device;
+  ice_threading::SubmissionThread &submission;
+  vk::DeviceSize slot_size;
+  std::vector<Slot> slots;
+
+  std::mutex lock;
+  std::condition_variable slot_freed;
+  bool failed{false};
+};
+}  // namespace ice
+
+#endif  // STAGING_RING_HPP
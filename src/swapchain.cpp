@@ -26,20 +26,6 @@ void SwapChainFrame::make_descriptor_resources() {
   camera_matrix_write_location = logical_device.mapMemory(
       camera_matrix_buffer.buffer_memory, 0, sizeof(CameraMatrices));
 
-  // model data
-  constexpr const std::uint32_t INSTANCES = 1024;
-  input.size = INSTANCES * sizeof(glm::mat4);
-  input.usage = vk::BufferUsageFlagBits::eStorageBuffer;
-  model_buffer = create_buffer(input);
-
-  model_buffer_write_location = logical_device.mapMemory(
-      model_buffer.buffer_memory, 0, INSTANCES * sizeof(glm::mat4));
-
-  model_transforms.reserve(INSTANCES);
-  for (std::uint32_t i = 0; i < INSTANCES; ++i) {
-    model_transforms.emplace_back(1.0f);
-  }
-
   camera_vector_descriptor_info = {.buffer = camera_vector_buffer.buffer,
                                    .offset = 0,
                                    .range = sizeof(CameraVectors)};
@@ -48,9 +34,46 @@ void SwapChainFrame::make_descriptor_resources() {
                                    .offset = 0,
                                    .range = sizeof(CameraMatrices)};
 
-  ssbo_descriptor_info = {.buffer = model_buffer.buffer,
-                          .offset = 0,
-                          .range = INSTANCES * sizeof(glm::mat4)};
+  // model data
+  make_model_buffer(MIN_INSTANCE_CAPACITY);
+}
+
+void SwapChainFrame::make_model_buffer(std::size_t capacity) {
+  if (instance_capacity != 0) {
+    destroy_model_buffer();
+  }
+
+  const std::size_t size = capacity * sizeof(InstanceTransform);
+  const BufferCreationInput input{
+      .size = size,
+      .usage = vk::BufferUsageFlagBits::eStorageBuffer,
+      .memory_properties = vk::MemoryPropertyFlagBits::eHostVisible |
+                           vk::MemoryPropertyFlagBits::eHostCoherent,
+      .logical_device = logical_device,
+
+      .physical_device = physical_device,
+  };
+  model_buffer = create_buffer(input);
+
+  model_buffer_write_location =
+      logical_device.mapMemory(model_buffer.buffer_memory, 0, size);
+
+  model_transforms.resize(capacity, make_instance_transform(glm::mat4(1.0f)));
+  instance_capacity = capacity;
+
+  // the glTF instances have to be copied into the new buffer
+  gltf_instance_offset = SIZE_MAX;
+
+  ssbo_descriptor_info = {
+      .buffer = model_buffer.buffer, .offset = 0, .range = size};
+}
+
+void SwapChainFrame::destroy_model_buffer() {
+  logical_device.unmapMemory(model_buffer.buffer_memory);
+  logical_device.freeMemory(model_buffer.buffer_memory);
+  logical_device.destroyBuffer(model_buffer.buffer);
+  model_buffer_write_location = nullptr;
+  instance_capacity = 0;
 }
 
 void SwapChainFrame::make_depth_resources() {
@@ -156,9 +179,7 @@ void SwapChainFrame::destroy(vk::CommandPool imgui_command_pool) {
   logical_device.destroyBuffer(camera_matrix_buffer.buffer);
 
   // obj data
-  logical_device.unmapMemory(model_buffer.buffer_memory);
-  logical_device.freeMemory(model_buffer.buffer_memory);
-  logical_device.destroyBuffer(model_buffer.buffer);
+  destroy_model_buffer();
 
   // depth resources
   logical_device.destroyImage(depth_buffer);
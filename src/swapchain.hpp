@@ -55,9 +55,18 @@ struct SwapChainFrame {
   BufferBundle camera_vector_buffer;
   void *camera_vector_write_location{};
 
-  std::vector<glm::mat4> model_transforms;
+  // OBJ instances first, then the glTF node instances. model_buffer holds
+  // instance_capacity transforms, grown with make_model_buffer when a scene
+  // needs more than that. Each one carries its normal matrix.
+  static constexpr std::size_t MIN_INSTANCE_CAPACITY = 4096;
+  std::size_t instance_capacity{0};
+  std::vector<InstanceTransform> model_transforms;
   BufferBundle model_buffer;
   void *model_buffer_write_location{};
+  // where and which version of the glTF instances model_buffer holds, they
+  // are only rewritten once they moved
+  std::size_t gltf_instance_offset{SIZE_MAX};
+  std::uint64_t gltf_transforms_version{0};
 
   // Resource Descriptors
   vk::DescriptorBufferInfo camera_vector_descriptor_info,
@@ -70,6 +79,13 @@ struct SwapChainFrame {
 
   void make_descriptor_resources();
 
+  // (Re)creates model_buffer for capacity transforms, the old one must not
+  // be in use by the GPU anymore. The descriptor set picks the new buffer up
+  // on the next write_descriptor_set.
+  void make_model_buffer(std::size_t capacity);
+
+  void destroy_model_buffer();
+
   void make_depth_resources();
 
   void make_color_resources();
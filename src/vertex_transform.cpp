@@ -0,0 +1,178 @@
+#include "vertex_transform.hpp"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define ICE_TRANSFORM_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ICE_TRANSFORM_SSE
+#include <emmintrin.h>
+#endif
+
+namespace ice {
+
+namespace {
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+              "the kernels expect tightly packed vectors");
+
+// Rows of the upper 3x4 part of an affine matrix
+struct Affine {
+  float r0[4];
+  float r1[4];
+  float r2[4];
+};
+
+Affine make_affine(const glm::mat4 &matrix) {
+  // glm is column major: matrix[column][row]
+  Affine affine{};
+  for (int column = 0; column < 4; ++column) {
+    affine.r0[column] = matrix[column][0];
+    affine.r1[column] = matrix[column][1];
+    affine.r2[column] = matrix[column][2];
+  }
+  return affine;
+}
+
+void transform_scalar(const Affine &m, float *data, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i, data += 3) {
+    const float x = data[0];
+    const float y = data[1];
+    const float z = data[2];
+    data[0] = m.r0[0] * x + m.r0[1] * y + m.r0[2] * z + m.r0[3];
+    data[1] = m.r1[0] * x + m.r1[1] * y + m.r1[2] * z + m.r1[3];
+    data[2] = m.r2[0] * x + m.r2[1] * y + m.r2[2] * z + m.r2[3];
+  }
+}
+
+#if defined(ICE_TRANSFORM_AVX2)
+// 8 vectors per block: both 128 bit lanes deinterleave 4 of them, as in the
+// SSE kernel
+void transform(const Affine &m, float *data, std::size_t count) {
+  const auto row = [](const float *r, int i) { return _mm256_set1_ps(r[i]); };
+  const __m256 m00 = row(m.r0, 0), m01 = row(m.r0, 1), m02 = row(m.r0, 2),
+               m03 = row(m.r0, 3);
+  const __m256 m10 = row(m.r1, 0), m11 = row(m.r1, 1), m12 = row(m.r1, 2),
+               m13 = row(m.r1, 3);
+  const __m256 m20 = row(m.r2, 0), m21 = row(m.r2, 1), m22 = row(m.r2, 2),
+               m23 = row(m.r2, 3);
+
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8, data += 24) {
+    // lane 0 holds vectors 0-3, lane 1 vectors 4-7
+    const __m256 a = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_loadu_ps(data)), _mm_loadu_ps(data + 12),
+        1);
+    const __m256 b = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_loadu_ps(data + 4)),
+        _mm_loadu_ps(data + 16), 1);
+    const __m256 c = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_loadu_ps(data + 8)),
+        _mm_loadu_ps(data + 20), 1);
+
+    // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 -> x, y, z
+    const __m256 xy = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    const __m256 yz = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+    const __m256 x = _mm256_shuffle_ps(a, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    const __m256 y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m256 z = _mm256_shuffle_ps(yz, c, _MM_SHUFFLE(3, 0, 3, 1));
+
+    const __m256 tx = _mm256_fmadd_ps(
+        m00, x, _mm256_fmadd_ps(m01, y, _mm256_fmadd_ps(m02, z, m03)));
+    const __m256 ty = _mm256_fmadd_ps(
+        m10, x, _mm256_fmadd_ps(m11, y, _mm256_fmadd_ps(m12, z, m13)));
+    const __m256 tz = _mm256_fmadd_ps(
+        m20, x, _mm256_fmadd_ps(m21, y, _mm256_fmadd_ps(m22, z, m23)));
+
+    // and back
+    const __m256 rxy = _mm256_shuffle_ps(tx, ty, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 ryz = _mm256_shuffle_ps(ty, tz, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m256 rzx = _mm256_shuffle_ps(tz, tx, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m256 ra = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 rb = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m256 rc = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+
+    _mm_storeu_ps(data, _mm256_castps256_ps128(ra));
+    _mm_storeu_ps(data + 4, _mm256_castps256_ps128(rb));
+    _mm_storeu_ps(data + 8, _mm256_castps256_ps128(rc));
+    _mm_storeu_ps(data + 12, _mm256_extractf128_ps(ra, 1));
+    _mm_storeu_ps(data + 16, _mm256_extractf128_ps(rb, 1));
+    _mm_storeu_ps(data + 20, _mm256_extractf128_ps(rc, 1));
+  }
+  transform_scalar(m, data, count - i);
+}
+#elif defined(ICE_TRANSFORM_SSE)
+void transform(const Affine &m, float *data, std::size_t count) {
+  const __m128 m00 = _mm_set1_ps(m.r0[0]), m01 = _mm_set1_ps(m.r0[1]),
+               m02 = _mm_set1_ps(m.r0[2]), m03 = _mm_set1_ps(m.r0[3]);
+  const __m128 m10 = _mm_set1_ps(m.r1[0]), m11 = _mm_set1_ps(m.r1[1]),
+               m12 = _mm_set1_ps(m.r1[2]), m13 = _mm_set1_ps(m.r1[3]);
+  const __m128 m20 = _mm_set1_ps(m.r2[0]), m21 = _mm_set1_ps(m.r2[1]),
+               m22 = _mm_set1_ps(m.r2[2]), m23 = _mm_set1_ps(m.r2[3]);
+
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4, data += 12) {
+    const __m128 a = _mm_loadu_ps(data);
+    const __m128 b = _mm_loadu_ps(data + 4);
+    const __m128 c = _mm_loadu_ps(data + 8);
+
+    // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 -> x, y, z
+    const __m128 xy = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+    const __m128 yz = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+    const __m128 x = _mm_shuffle_ps(a, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    const __m128 y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128 z = _mm_shuffle_ps(yz, c, _MM_SHUFFLE(3, 0, 3, 1));
+
+    const __m128 tx = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)),
+        _mm_add_ps(_mm_mul_ps(m02, z), m03));
+    const __m128 ty = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)),
+        _mm_add_ps(_mm_mul_ps(m12, z), m13));
+    const __m128 tz = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)),
+        _mm_add_ps(_mm_mul_ps(m22, z), m23));
+
+    // and back
+    const __m128 rxy = _mm_shuffle_ps(tx, ty, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 ryz = _mm_shuffle_ps(ty, tz, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m128 rzx = _mm_shuffle_ps(tz, tx, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_ps(data, _mm_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(data + 4,
+                  _mm_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm_storeu_ps(data + 8,
+                  _mm_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  transform_scalar(m, data, count - i);
+}
+#else
+void transform(const Affine &m, float *data, std::size_t count) {
+  transform_scalar(m, data, count);
+}
+#endif
+}  // namespace
+
+void transform_points(const glm::mat4 &matrix, std::span<glm::vec3> points) {
+  if (!points.empty()) {
+    transform(make_affine(matrix), &points.front().x, points.size());
+  }
+}
+
+void transform_directions(const glm::mat3 &matrix,
+                          std::span<glm::vec3> directions) {
+  // no translation column
+  if (!directions.empty()) {
+    transform(make_affine(glm::mat4(matrix)), &directions.front().x,
+              directions.size());
+  }
+}
+
+const char *vertex_transform_kernel() {
+#if defined(ICE_TRANSFORM_AVX2)
+  return "AVX2";
+#elif defined(ICE_TRANSFORM_SSE)
+  return "SSE";
+#else
+  return "scalar";
+#endif
+}
+}  // namespace ice
@@ -0,0 +1,30 @@
+#ifndef VERTEX_TRANSFORM_HPP
+#define VERTEX_TRANSFORM_HPP
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+namespace ice {
+
+/**
+ * Batch transforms of packed glm::vec3 arrays, in place. Blocks of 8 (AVX2
+ * and FMA) or 4 (SSE) consecutive vectors are deinterleaved into x, y and z
+ * registers, so every multiply-add works on a whole block; the tail of an
+ * array and CPUs without SSE use the scalar loop. The kernel is picked at
+ * compile time, configure with ICE_ENABLE_AVX2 for the AVX2 one.
+ */
+
+// points[i] = matrix * vec4(points[i], 1). The bottom row of matrix is
+// ignored, it has to be affine (pre-transforms and glTF node transforms are).
+void transform_points(const glm::mat4 &matrix, std::span<glm::vec3> points);
+
+// directions[i] = matrix * directions[i], for normals pass the normal matrix
+void transform_directions(const glm::mat3 &matrix,
+                          std::span<glm::vec3> directions);
+
+// "AVX2", "SSE" or "scalar", the kernel compiled in
+const char *vertex_transform_kernel();
+}  // namespace ice
+
+#endif  // VERTEX_TRANSFORM_HPP
@@ -1,5 +1,10 @@
 #include "vulkan_ice.hpp"
 
+#include <bit>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
 #include "game_objects.hpp"
 #include "images/ice_cube_map.hpp"
 #include "mesh.hpp"
@@ -56,10 +61,12 @@ VulkanIce::VulkanIce(IceWindow &window)
 
   make_worker_threads();
   make_assets();
-  end_worker_threads();
 }
 
 VulkanIce::~VulkanIce() noexcept {
+  // workers may still be recording or submitting
+  end_worker_threads();
+
   try {
     device.waitIdle();
   } catch (...) {
@@ -95,6 +102,7 @@ VulkanIce::~VulkanIce() noexcept {
     texture.reset();
   }
   cube_map.reset();
+  texture_staging.reset();
 
   device.destroy();
 
@@ -346,6 +354,7 @@ void VulkanIce::setup_imgui_overlay() {
 
 void VulkanIce::rebuild_pipelines() {
   try {
+    const auto queue_guard = graphics_submission->lock_queue();
     device.waitIdle();
   } catch (...) {
 #ifndef NDEBUG
@@ -573,7 +582,10 @@ void VulkanIce::recreate_swapchain(bool recreate_pipeline) {
     window_dim = window.get_framebuffer_size();
     ice::IceWindow::wait_events();
   }
-  device.waitIdle();
+  {
+    const auto queue_guard = graphics_submission->lock_queue();
+    device.waitIdle();
+  }
 
   // preserve old swapchain handle for recreation
   vk::SwapchainKHR old_swapchain = swapchain;
@@ -619,23 +631,46 @@ void VulkanIce::recreate_swapchain(bool recreate_pipeline) {
 }
 
 void VulkanIce::make_worker_threads() {
-  done = false;
-  const std::size_t thread_count = std::jthread::hardware_concurrency() - 1;
+  // ICE_TRACE=<prefix> writes <prefix>_startup.json once the assets are
+  // loaded and <prefix>_frames.json (the last frames) on shutdown
+  if (const char *trace_prefix = std::getenv("ICE_TRACE")) {
+    trace_path_prefix = trace_prefix;
+    ice_threading::start_tracing();
+  }
+  ice_threading::set_trace_thread_name("main");
+
+  // keep one core for the main thread, but always have at least one worker
+  const std::size_t hardware_threads = std::jthread::hardware_concurrency();
+  const std::size_t thread_count =
+      hardware_threads > 1 ? hardware_threads - 1 : 1;
+
+  scheduler = std::make_unique<ice_threading::Scheduler>(thread_count);
+  scheduler->register_thread(0, {.command_buffer = main_command_buffer,
+                                 .queue = graphics_queue});
+
+  // uploads from every thread are submitted by one thread
+  graphics_submission = std::make_unique<ice_threading::SubmissionThread>(
+      device, graphics_queue, indices.graphics_family.value_or(0));
+  // asset files are read by one thread, the workers keep decoding meanwhile
+  io_thread = std::make_unique<ice_threading::IoThread>();
 
   workers.reserve(thread_count);
-  const CommandBufferReq command_buffer_input = {device, command_pool,
-                                                 swapchain_frames};
+  worker_command_pools.reserve(thread_count);
   for (std::size_t i = 0; i < thread_count; ++i) {
+    worker_command_pools.push_back(
+        make_command_pool(device, physical_device, surface));
+    const CommandBufferReq command_buffer_input = {
+        device, worker_command_pools.back(), swapchain_frames};
     const vk::CommandBuffer command_buffer =
         make_command_buffer(command_buffer_input);
     workers.emplace_back(ice_threading::WorkerThread(
-        work_queue, done, command_buffer, graphics_queue));
+        *scheduler, i + 1, command_buffer, graphics_queue));
   }
 }
 
 void VulkanIce::make_assets() {
   // Meshes
-  meshes = std::make_unique<MeshCollator>();
+  meshes = std::make_unique<MeshCollator>(scheduler.get());
   // meshes = new MeshCollator();
 
   // Coordinate system from GLM (OpenGL) Left handed from Model's perspective
@@ -667,6 +702,30 @@ void VulkanIce::make_assets() {
   // stores models to be loaded
   std::unordered_map<MeshTypes, ObjMesh> models;
 
+  // ICE_MESH_BUDGET_MB=<n> streams the OBJ meshes to the GPU in batches,
+  // with at most n MiB of host memory for parsing and staging them. Values
+  // that are not a whole number of at least MIN_STREAMING_BUDGET are
+  // rejected and the meshes load whole.
+  std::size_t mesh_memory_budget = 0;
+  if (const char *budget = std::getenv("ICE_MESH_BUDGET_MB")) {
+    const char *budget_end = budget + std::strlen(budget);
+    std::size_t budget_mb = 0;
+    const auto [parsed_end, error] =
+        std::from_chars(budget, budget_end, budget_mb);
+    if (error == std::errc{} && parsed_end == budget_end &&
+        budget_mb <= (SIZE_MAX >> 20) &&
+        (budget_mb << 20) >= MIN_STREAMING_BUDGET) {
+      mesh_memory_budget = budget_mb << 20;
+    } else {
+#ifndef NDEBUG
+      std::cerr << std::format(
+          "Ignoring ICE_MESH_BUDGET_MB={}, expected a whole number of MiB "
+          "of at least {} KiB\n",
+          budget, MIN_STREAMING_BUDGET >> 10);
+#endif
+    }
+  }
+
   // Materials (Textures) prep
   std::unordered_map<MeshTypes, const char *> texture_filenames = {
       {MeshTypes::GROUND, "resources/textures/ground.jpg"},
@@ -678,90 +737,23 @@ void VulkanIce::make_assets() {
       device, static_cast<uint32_t>(texture_filenames.size()) + 1,
       mesh_set_layout_bindings);  // extra set for cube map
 
+  texture_staging = std::make_unique<ice::StagingAllocator>(
+      ice::StagingAllocatorInput{.physical_device = physical_device,
+                                 .logical_device = device});
+
   ice_image::TextureCreationInput texture_info{
       .physical_device = physical_device,
       .logical_device = device,
       .command_buffer = main_command_buffer,
       .queue = graphics_queue,
       .layout = mesh_set_layout[PipelineType::STANDARD],
-      .descriptor_pool = mesh_descriptor_pool};
-
-#ifndef NDEBUG
-  // Time to load OBJ Meshes
-  auto start = std::chrono::high_resolution_clock::now();
-#endif
-
-  // Submit loading work
-  work_queue.lock.lock();
-  // std::tuple<MeshTypes, std::vector<const char*>, glm::mat4>
-  for (const auto &[mesh_type, obj_mtl_filename, pre_transform] :
-       model_inputs) {
-    texture_info.filenames = {texture_filenames[mesh_type]};
-
-    // Default construct without loading
-    materials[mesh_type] = std::make_shared<ice_image::Texture>();
-    models[mesh_type] = ObjMesh();
-
-    // Add loading jobs
-    work_queue.add(
-        new ice_threading::MakeTexture(materials[mesh_type], texture_info));
-    // MakeModel(ice::ObjMesh &mesh, const char *obj_filepath, const char
-    // *mtl_filepath, glm::mat4 pre_transform)
-    work_queue.add(
-        new ice_threading::MakeModel(models[mesh_type], obj_mtl_filename[0],
-                                     obj_mtl_filename[1], pre_transform));
-  }
-
-  work_queue.lock.unlock();
-
-  // loading work to be done by background thread, wait till completion
-#ifndef NDEBUG
-  std::cout << "Waiting for work to finish." << std::endl;
-#endif
-
-  while (true) {
-    if (!work_queue.lock.try_lock()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(200));
-      continue;
-    }
-
-    if (work_queue.done()) {
-#ifndef NDEBUG
-      std::cout << "Work finished" << std::endl;
-#endif
-      work_queue.clear();
-      work_queue.lock.unlock();
-      break;
-    }
-    work_queue.lock.unlock();
-  }
-
-  // Consume loaded meshes
-  // std::pair<MeshTypes, ObjMesh>
-  for (const auto &[mesh_type, model] : models) {
-    meshes->consume(mesh_type, model.vertices, model.indices);
-  }
-
-  const VertexBufferFinalizationInput finalization_info{
-      .logical_device = device,
-      .physical_device = physical_device,
-      .command_buffer = main_command_buffer,
-      .queue = graphics_queue};
-
-  meshes->finalize(finalization_info);
-
-#ifndef NDEBUG
-  auto end = std::chrono::high_resolution_clock::now();
-  std::chrono::duration<double> elapsed_seconds = end - start;
-  std::cout << std::format("Mesh loading took {} seconds",
-                           elapsed_seconds.count())
-            << std::endl;
-  start = std::chrono::high_resolution_clock::now();
-#endif
+      .descriptor_pool = mesh_descriptor_pool,
+      .staging = texture_staging.get()};
 
   // Sky Texture
-  texture_info.layout = mesh_set_layout[PipelineType::SKY];
-  texture_info.filenames = {{
+  ice_image::TextureCreationInput sky_texture_info = texture_info;
+  sky_texture_info.layout = mesh_set_layout[PipelineType::SKY];
+  sky_texture_info.filenames = {{
       // This arrangement correctly formats skyboxes authored for OpenGL
       "resources/textures/sky_front.png",   // x+
       "resources/textures/sky_back.png",    // x-
@@ -770,16 +762,6 @@ void VulkanIce::make_assets() {
       "resources/textures/sky_right.png",   // z-
       "resources/textures/sky_left.png",    // z+
   }};
-  cube_map = std::make_unique<ice_image::CubeMap>(texture_info);
-
-#ifndef NDEBUG
-  end = std::chrono::high_resolution_clock::now();
-  elapsed_seconds = end - start;
-  std::cout << std::format("Cubemap textures loading took {} seconds\n\n",
-                           elapsed_seconds.count())
-            << std::endl;
-  start = std::chrono::high_resolution_clock::now();
-#endif
 
   // GltfMesh
   // Create a larger descriptor pool for GLTF mesh textures
@@ -798,42 +780,224 @@ void VulkanIce::make_assets() {
    * (+y), +z is forwards (out of the screen/towards the cam)
    */
   // TRS
-  glm::mat4 pre_transform =
+  glm::mat4 gltf_pre_transform =
       glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 10.0f, 5.0f));
 
-  pre_transform = glm::rotate(pre_transform, glm::radians(180.0f),
-                              glm::vec3(0.0f, 1.0f, 0.0f));
-  pre_transform = glm::rotate(pre_transform, glm::radians(-180.0f),
-                              glm::vec3(1.0f, 0.0f, 0.0f));
+  gltf_pre_transform = glm::rotate(gltf_pre_transform, glm::radians(180.0f),
+                                   glm::vec3(0.0f, 1.0f, 0.0f));
+  gltf_pre_transform = glm::rotate(gltf_pre_transform, glm::radians(-180.0f),
+                                   glm::vec3(1.0f, 0.0f, 0.0f));
 
-  pre_transform = glm::rotate(pre_transform, glm::radians(180.0f),
-                              glm::vec3(0.0f, 0.0f, 1.0f));
+  gltf_pre_transform = glm::rotate(gltf_pre_transform, glm::radians(180.0f),
+                                   glm::vec3(0.0f, 0.0f, 1.0f));
 
-  pre_transform = glm::rotate(pre_transform, glm::radians(180.0f),
-                              glm::vec3(0.0f, 1.0f, 0.0f));
+  gltf_pre_transform = glm::rotate(gltf_pre_transform, glm::radians(180.0f),
+                                   glm::vec3(0.0f, 1.0f, 0.0f));
 
-  pre_transform = glm::scale(pre_transform, glm::vec3(3.0f, 3.0f, 3.0f));
+  gltf_pre_transform =
+      glm::scale(gltf_pre_transform, glm::vec3(3.0f, 3.0f, 3.0f));
 
-#ifndef NDEBUG
-  // time to load GLTF mesh
-  start = std::chrono::high_resolution_clock::now();
-#endif
-  // make GLTF MESH
+  // make GLTF MESH, loaded by the jobs below
   gltf_mesh = std::make_unique<GltfMesh>(
       physical_device, device, main_command_buffer, graphics_queue,
       mesh_set_layout[PipelineType::STANDARD], gltf_descriptor_pool,
-      // "resources/models/Box.gltf", pre_transform);
-      // "resources/models/ToyCar.glb", pre_transform); // very tiny
-      // increase scale to see it "resources/models/Suzanne.gltf",
-      // pre_transform);
-      "resources/models/DamagedHelmet.gltf", pre_transform);
+      gltf_pre_transform, scheduler.get(), &texture_cache,
+      texture_staging.get());
+  // "resources/models/Box.gltf"
+  // "resources/models/ToyCar.glb" // very tiny
+  // increase scale to see it "resources/models/Suzanne.gltf"
+  const char *gltf_filepath = "resources/models/DamagedHelmet.gltf";
 
 #ifndef NDEBUG
-  end = std::chrono::high_resolution_clock::now();
-  elapsed_seconds = end - start;
-  std::cout << std::format("Time taken to load GLTF mesh: {}s\n",
-                           elapsed_seconds.count());
+  // Time to load all assets
+  auto start = std::chrono::high_resolution_clock::now();
 #endif
+  const ice_threading::TraceClock::time_point trace_start =
+      ice_threading::TraceClock::now();
+
+  /*
+   * Asset job graph, independent branches overlap:
+   * decode_texture -> UploadTexture -------------------> material descriptors
+   * CubeMap ------------------------------------------/
+   * MakeModel (per OBJ) -> collate -> finalize
+   * glTF parse -> decode per primitive and image (children) -> glTF upload
+   * Texture decodes and the glTF upload are coroutines (TaskJob), which
+   * release their thread while a file is read or a copy runs on the GPU.
+   * Descriptor sets are written by a single job since the pool they are
+   * allocated from must not be accessed concurrently.
+   */
+  using ice_threading::FunctionJob;
+  std::vector<ice_threading::Job *> asset_jobs;
+
+  // only the materials created here, their sets come from
+  // mesh_descriptor_pool. Shared ones get theirs from their creator.
+  std::vector<ice_image::Texture *> created_materials;
+  auto *material_descriptors = new FunctionJob(
+      [&created_materials](vk::CommandBuffer, vk::Queue) {
+        for (ice_image::Texture *material : created_materials) {
+          material->make_descriptor_set();
+        }
+      });
+  material_descriptors->trace_name = "material descriptors";
+  asset_jobs.push_back(material_descriptors);
+
+  auto *collate = new FunctionJob([this, &models, &model_inputs,
+                                   mesh_memory_budget](vk::CommandBuffer,
+                                                       vk::Queue) {
+    if (mesh_memory_budget > 0) {
+      std::vector<ObjStreamSource> sources;
+      for (const auto &[mesh_type, obj_mtl_filename, pre_transform] :
+           model_inputs) {
+        sources.push_back({.type = mesh_type,
+                           .obj_filepath = obj_mtl_filename[0],
+                           .mtl_filepath = obj_mtl_filename[1],
+                           .pre_transform = pre_transform});
+      }
+      meshes->stream({.logical_device = device,
+                      .physical_device = physical_device,
+                      .submission = graphics_submission.get(),
+                      .memory_budget = mesh_memory_budget},
+                     sources);
+      return;
+    }
+
+    // Consume loaded meshes
+    // std::pair<MeshTypes, ObjMesh>
+    for (const auto &[mesh_type, model] : models) {
+      meshes->consume(mesh_type, model.vertex_data(), model.index_data());
+    }
+  });
+  collate->trace_name =
+      mesh_memory_budget > 0 ? "stream meshes" : "collate meshes";
+  asset_jobs.push_back(collate);
+
+  auto *finalize = new FunctionJob(
+      [this, mesh_memory_budget](vk::CommandBuffer command_buffer,
+                                 vk::Queue queue) {
+        // streaming already filled the buffers
+        if (mesh_memory_budget > 0) {
+          return;
+        }
+        const VertexBufferFinalizationInput finalization_info{
+            .logical_device = device,
+            .physical_device = physical_device,
+            .command_buffer = command_buffer,
+            .queue = queue};
+
+        meshes->finalize(finalization_info);
+      });
+  finalize->trace_name = "finalize meshes";
+  finalize->depends_on(collate);
+  asset_jobs.push_back(finalize);
+
+  // std::tuple<MeshTypes, std::vector<const char*>, glm::mat4>
+  for (const auto &[mesh_type, obj_mtl_filename, pre_transform] :
+       model_inputs) {
+    texture_info.filenames = {texture_filenames[mesh_type]};
+
+    // Default construct without loading
+    models[mesh_type] = ObjMesh();
+
+    // meshes using the same image file share its texture, only the first
+    // one decodes and uploads it
+    const ice_image::TextureCache::Entry material = texture_cache.acquire(
+        ice_image::TextureCache::file_key(texture_filenames[mesh_type]));
+    materials[mesh_type] = material.texture;
+    if (material.created) {
+      created_materials.push_back(material.texture.get());
+      auto *decode_texture = new ice_threading::TaskJob(
+          *scheduler,
+          ice_threading::decode_texture(*io_thread, *scheduler,
+                                        material.texture, texture_info));
+      decode_texture->trace_name = "decode texture";
+      auto *upload_texture = new ice_threading::UploadTexture(material.texture);
+      upload_texture->depends_on(decode_texture);
+      material_descriptors->depends_on(upload_texture);
+
+      asset_jobs.insert(asset_jobs.end(), {decode_texture, upload_texture});
+    }
+    if (mesh_memory_budget > 0) {
+      continue;
+    }
+
+    // MakeModel(ice::ObjMesh &mesh, const char *obj_filepath, const char
+    // *mtl_filepath, glm::mat4 pre_transform, Scheduler *scheduler)
+    auto *make_model = new ice_threading::MakeModel(
+        models[mesh_type], obj_mtl_filename[0], obj_mtl_filename[1],
+        pre_transform, scheduler.get());
+    collate->depends_on(make_model);
+    asset_jobs.push_back(make_model);
+  }
+
+  auto *make_cube_map = new FunctionJob(
+      [this, &sky_texture_info](vk::CommandBuffer command_buffer,
+                                vk::Queue queue) {
+        ice_image::TextureCreationInput info = sky_texture_info;
+        info.command_buffer = command_buffer;
+        info.queue = queue;
+        cube_map = std::make_unique<ice_image::CubeMap>(info, scheduler.get());
+      });
+  make_cube_map->trace_name = "make cube map";
+  material_descriptors->depends_on(make_cube_map);
+  asset_jobs.push_back(make_cube_map);
+
+  auto *parse_gltf = new FunctionJob(
+      [this, gltf_filepath](vk::CommandBuffer, vk::Queue) {
+        gltf_mesh->parse(gltf_filepath);
+        for (std::size_t i = 0; i < gltf_mesh->primitive_count(); ++i) {
+          auto *decode = new FunctionJob(
+              [this, i](vk::CommandBuffer, vk::Queue) {
+                gltf_mesh->decode_primitive(i);
+              });
+          decode->trace_name = "decode glTF primitive";
+          scheduler->submit_child(decode);
+        }
+        for (std::size_t i = 0; i < gltf_mesh->image_count(); ++i) {
+          auto *decode = new FunctionJob(
+              [this, i](vk::CommandBuffer, vk::Queue) {
+                gltf_mesh->decode_image(i);
+              });
+          decode->trace_name = "decode glTF image";
+          scheduler->submit_child(decode);
+        }
+      });
+  parse_gltf->trace_name = "parse glTF";
+  auto *upload_gltf = new ice_threading::TaskJob(
+      *scheduler, gltf_mesh->upload_async(*graphics_submission));
+  upload_gltf->trace_name = "upload glTF";
+  upload_gltf->depends_on(parse_gltf);
+  asset_jobs.insert(asset_jobs.end(), {parse_gltf, upload_gltf});
+
+  // every edge is declared, submit the whole graph
+  ice_threading::JobCounter assets_loaded;
+  for (ice_threading::Job *job : asset_jobs) {
+    scheduler->submit(job, &assets_loaded);
+  }
+
+#ifndef NDEBUG
+  std::cout << "Waiting for work to finish." << std::endl;
+#endif
+
+  scheduler->wait(assets_loaded);
+  // keep no staging memory around until the next upload
+  texture_staging->trim();
+
+#ifndef NDEBUG
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> elapsed_seconds = end - start;
+  std::cout << std::format("Asset loading took {} seconds\n",
+                           elapsed_seconds.count())
+            << std::endl;
+#endif
+
+  if (ice_threading::tracing()) {
+    ice_threading::trace_event("load assets",
+                               ice_threading::TraceCategory::FRAME, trace_start,
+                               ice_threading::TraceClock::now());
+    // the frames get a trace of their own
+    export_trace("_startup.json");
+    ice_threading::clear_trace();
+  }
 
   std::array<vk::DescriptorPoolSize, 11> imgui_pool_sizes = {
       vk::DescriptorPoolSize{vk::DescriptorType::eSampler, 1000},
@@ -867,26 +1031,131 @@ void VulkanIce::make_assets() {
 #endif
 }
 
-void VulkanIce::end_worker_threads() {
-  done = true;
+void VulkanIce::end_worker_threads() noexcept {
+  if (!scheduler) {
+    return;
+  }
+  scheduler->stop();
+
+#ifndef NDEBUG
+  // queue wait per priority over the engine's lifetime
+  constexpr std::array<const char *, ice_threading::PRIORITY_COUNT>
+      priority_names = {"high", "normal", "low"};
+  const ice_threading::Scheduler::Stats stats = scheduler->stats();
+  for (std::size_t i = 0; i < stats.size(); ++i) {
+    const auto average_wait =
+        stats[i].executed == 0
+            ? 0.0
+            : std::chrono::duration<double, std::micro>(stats[i].total_wait)
+                      .count() /
+                  static_cast<double>(stats[i].executed);
+    std::cout << std::format(
+        "Jobs ({:<6}): {} executed, {} cancelled, queue wait avg {:.1f}us, "
+        "max {:.1f}us\n",
+        priority_names[i], stats[i].executed, stats[i].cancelled,
+        average_wait,
+        std::chrono::duration<double, std::micro>(stats[i].max_wait).count());
+  }
+#endif
 
   for (auto &worker : workers) {
     worker.join();
   }
+  workers.clear();
+  // both drain what is in flight, their completions queue the resumption of
+  // the waiting tasks on the scheduler, so they go first
+  graphics_submission.reset();
+  io_thread.reset();
+  // drops the queued jobs and destroys the suspended tasks
+  scheduler.reset();
+
+  for (const vk::CommandPool pool : worker_command_pools) {
+    device.destroyCommandPool(pool);
+  }
+  worker_command_pools.clear();
 #ifndef NDEBUG
   std::cout << "Threads ended successfully." << std::endl;
 #endif
+
+  // every traced thread has exited
+  if (ice_threading::tracing()) {
+    ice_threading::stop_tracing();
+    export_trace("_frames.json");
+  }
+}
+
+void VulkanIce::export_trace(const char *suffix) noexcept {
+  try {
+    const std::string path = trace_path_prefix + suffix;
+    if (!ice_threading::write_chrome_trace(path)) {
+#ifndef NDEBUG
+      std::cerr << std::format("Failed to write trace {}\n", path);
+#endif
+    }
+  } catch (const std::exception &err) {
+#ifndef NDEBUG
+    std::cerr << std::format("Failed to write trace: {}\n", err.what());
+#endif
+  }
 }
 
 void VulkanIce::prepare_frame(std::uint32_t image_index, Scene *scene) {
+  SwapChainFrame &frame =
+      swapchain_frames[image_index];  // swapchain frame alias
+
+  // grow the model buffer before anything writes past its end
+  const std::vector<InstanceTransform> &gltf_instances =
+      gltf_mesh->instance_transforms;
+  std::size_t needed_instances = gltf_instances.size();
+  for (const auto &pair : scene->positions) {
+    needed_instances += pair.second.size();
+  }
+  if (needed_instances > frame.instance_capacity) {
+#ifndef NDEBUG
+    std::cout << std::format("Growing the model buffer from {} to {}\n",
+                             frame.instance_capacity,
+                             std::bit_ceil(needed_instances));
+#endif
+    // The old buffer may still be read by any frame in flight: the
+    // descriptor sets of an image are bound by whichever frame acquired it,
+    // so no single fence covers them. Waiting for the device needs every
+    // queue, the upload threads included, to hold still.
+    {
+      const auto queue_guard = graphics_submission->lock_queue();
+      device.waitIdle();
+    }
+    frame.make_model_buffer(std::bit_ceil(needed_instances));
+  }
+
+  // model transforms info, built by the workers while the camera updates
+  ice_threading::FramePhase transform_phase(*scheduler);
+  size_t instance_count = 0;
+  for (const auto &pair : scene->positions) {
+    const std::vector<glm::vec3> &positions = pair.second;
+    auto *transforms = new ice_threading::FunctionJob(
+        [this, &frame, &positions, offset = instance_count](
+            vk::CommandBuffer, vk::Queue) {
+          ice_threading::parallel_for(
+              scheduler.get(), 0, positions.size(), 256,
+              [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i) {
+                  // translations leave the normals as they are
+                  frame.model_transforms[offset + i] = {
+                      .model = glm::translate(glm::mat4(1.0f), positions[i]),
+                      .normal = glm::mat4(1.0f)};
+                }
+              });
+        });
+    transforms->trace_name = "model transforms";
+    transform_phase.submit(transforms);
+    instance_count += positions.size();
+  }
+
   // camera code
   camera.inputs(&window);
   // increase far plane distance to prevent clipping
   camera.update_matrices(45.0f, 0.1f, 100000.0f);
 
-  SwapChainFrame &frame =
-      swapchain_frames[image_index];  // swapchain frame alias
-
   // update camera vector
   frame.camera_vector_data = camera.get_camera_vector();
 
@@ -899,17 +1168,22 @@ void VulkanIce::prepare_frame(std::uint32_t image_index, Scene *scene) {
   memcpy(frame.camera_matrix_write_location, &(frame.camera_matrix_data),
          sizeof(CameraMatrices));
 
-  // model transforms info
-  size_t i = 0;
-  for (const std::pair<MeshTypes, std::vector<glm::vec3>> pair :
-       scene->positions) {
-    for (const glm::vec3 &position : pair.second) {
-      frame.model_transforms[i++] = glm::translate(glm::mat4(1.0f), position);
-    }
-  }
-
+  transform_phase.wait();
   memcpy(frame.model_buffer_write_location, frame.model_transforms.data(),
-         i * sizeof(glm::mat4));
+         instance_count * sizeof(InstanceTransform));
+
+  // glTF node instances follow the OBJ ones, this frame's copy is only
+  // refreshed after update_transforms moved them
+  if (frame.gltf_instance_offset != instance_count ||
+      frame.gltf_transforms_version != gltf_mesh->transforms_version()) {
+    memcpy(
+        static_cast<InstanceTransform *>(frame.model_buffer_write_location) +
+            instance_count,
+        gltf_instances.data(),
+        gltf_instances.size() * sizeof(InstanceTransform));
+    frame.gltf_instance_offset = instance_count;
+    frame.gltf_transforms_version = gltf_mesh->transforms_version();
+  }
 
   frame.write_descriptor_set();
 }
@@ -926,11 +1200,18 @@ void VulkanIce::prepare_scene(vk::CommandBuffer command_buffer) {
 
 // @brief Logic for rendering frames.
 void VulkanIce::render(Scene *scene) {
+  const ice_threading::TraceScope frame_trace(
+      "frame", ice_threading::TraceCategory::FRAME);
   const ice::SwapChainFrame &current_frame =
       swapchain_frames[current_frame_index];  // alias
 
-  vk::Result result = device.waitForFences(1, &current_frame.in_flight_fence,
-                                           vk::True, UINT64_MAX);
+  vk::Result result;
+  {
+    const ice_threading::TraceScope trace("wait for frame fence",
+                                          ice_threading::TraceCategory::WAIT);
+    result = device.waitForFences(1, &current_frame.in_flight_fence, vk::True,
+                                  UINT64_MAX);
+  }
   // reset fence just before queue submit
   result = device.resetFences(1, &current_frame.in_flight_fence);
 
@@ -1034,6 +1315,10 @@ void VulkanIce::render(Scene *scene) {
       .pSignalSemaphores = signal_semaphores.data()};
 
   try {
+    // the queues are shared with the upload submission thread
+    const auto queue_guard = graphics_submission->lock_queue();
+    const ice_threading::TraceScope trace("frame submit",
+                                          ice_threading::TraceCategory::SUBMIT);
     graphics_queue.submit(submit_info, current_frame.in_flight_fence);
   } catch (const vk::SystemError &err) {
     throw std::runtime_error("failed to submit draw command buffer!");
@@ -1049,6 +1334,7 @@ void VulkanIce::render(Scene *scene) {
   };
 
   try {
+    const auto queue_guard = graphics_submission->lock_queue();
     result = present_queue.presentKHR(present_info);
   } catch (const vk::OutOfDateKHRError &err) {
 #ifndef NDEBUG
@@ -1185,22 +1471,20 @@ void VulkanIce::record_scene_draw_commands(vk::CommandBuffer command_buffer,
                 static_cast<uint32_t>(positions.size()));
   }
 
-  // Bind GltfMesh buffers and draw
-  for (size_t i = 0; i < gltf_mesh->mesh_buffers.size(); ++i) {
-    const auto &mesh_buffer = gltf_mesh->mesh_buffers[i];
-
-    // Bind vertex buffer
+  // Draw GltfMesh primitives from its shared buffers, every primitive once
+  // for all the nodes of its mesh. Their instances come after the OBJ ones.
+  if (!gltf_mesh->primitive_ranges.empty()) {
     std::array<vk::Buffer, 1> vertex_buffers = {
-        mesh_buffer.vertex_buffer.buffer};
+        gltf_mesh->vertex_buffer.buffer};
     std::array<vk::DeviceSize, 1> offsets = {0};
     command_buffer.bindVertexBuffers(
         0, static_cast<std::uint32_t>(vertex_buffers.size()),
         vertex_buffers.data(), offsets.data());
-
-    // Bind index buffer
-    command_buffer.bindIndexBuffer(mesh_buffer.index_buffer.buffer, 0,
+    command_buffer.bindIndexBuffer(gltf_mesh->index_buffer.buffer, 0,
                                    vk::IndexType::eUint32);
-
+  }
+  const std::uint32_t gltf_first_instance = start_instance;
+  for (size_t i = 0; i < gltf_mesh->primitive_ranges.size(); ++i) {
     // Bind texture
     if (i < gltf_mesh->textures.size() && gltf_mesh->textures[i] != nullptr) {
       gltf_mesh->textures[i]->use(command_buffer,
@@ -1208,8 +1492,11 @@ void VulkanIce::record_scene_draw_commands(vk::CommandBuffer command_buffer,
     }
 
     // Draw the mesh
-    const std::uint32_t index_count = gltf_mesh->index_counts[i];
-    command_buffer.drawIndexed(index_count, 1, 0, 0, 0);
+    const GltfPrimitiveRange &range = gltf_mesh->primitive_ranges[i];
+    const GltfInstances &instances = gltf_mesh->primitive_instances[i];
+    command_buffer.drawIndexed(gltf_mesh->index_counts[i], instances.count,
+                               range.first_index, range.vertex_offset,
+                               gltf_first_instance + instances.first);
   }
 
   command_buffer.endRenderPass();
@@ -12,12 +12,20 @@
 #include "framebuffer.hpp"
 #include "images/ice_cube_map.hpp"
 #include "images/ice_texture.hpp"
+#include "images/ice_texture_cache.hpp"
 #include "mesh.hpp"
 #include "mesh_collator.hpp"
+#include "multithreading/ice_frame_phase.hpp"
+#include "multithreading/ice_io_thread.hpp"
 #include "multithreading/ice_jobs.hpp"
+#include "multithreading/ice_parallel.hpp"
+#include "multithreading/ice_scheduler.hpp"
+#include "multithreading/ice_submission_thread.hpp"
+#include "multithreading/ice_trace.hpp"
 #include "multithreading/ice_worker_threads.hpp"
 #include "pipeline.hpp"
 #include "queue.hpp"
+#include "staging_allocator.hpp"
 #include "swapchain.hpp"
 #include "synchronization.hpp"
 #include "windowing.hpp"
@@ -91,10 +99,14 @@ class VulkanIce {
   void setup_command_buffers();
   void setup_frame_resources();
 
-  // asset setup
+  // job system, lives as long as the engine
   void make_worker_threads();
+  void end_worker_threads() noexcept;
+  // writes the trace to trace_path_prefix + suffix
+  void export_trace(const char *suffix) noexcept;
+
+  // asset setup
   void make_assets();
-  void end_worker_threads();
 
   // frame and scene prep
   void prepare_frame(std::uint32_t image_index, Scene *scene);
@@ -124,16 +136,25 @@ class VulkanIce {
   std::uint32_t max_frames_in_flight{0}, current_frame_index{0};
 
   // assets pointers
+  // staging memory the texture decodes write into, recycled between them
+  std::unique_ptr<ice::StagingAllocator> texture_staging;
   std::unique_ptr<MeshCollator> meshes;
+  // shares the textures of the OBJ materials and the glTF primitives
+  ice_image::TextureCache texture_cache;
   std::unordered_map<MeshTypes, std::shared_ptr<ice_image::Texture>> materials;
   std::unique_ptr<GltfMesh> gltf_mesh;
   std::unique_ptr<ice_image::CubeMap> cube_map;
   Camera camera;
 
   // Job System
-  bool done = false;
-  ice_threading::WorkQueue work_queue;
+  std::unique_ptr<ice_threading::Scheduler> scheduler;
   std::vector<std::jthread> workers;
+  // command pools are externally synchronized, each worker records from its
+  // own
+  std::vector<vk::CommandPool> worker_command_pools;
+  std::unique_ptr<ice_threading::SubmissionThread> graphics_submission;
+  std::unique_ptr<ice_threading::IoThread> io_thread;
+  std::string trace_path_prefix;  // empty unless tracing
 
   // descriptor-related variables
   std::unordered_map<PipelineType, vk::DescriptorSetLayout> frame_set_layout;
@@ -0,0 +1,17 @@
+#ifndef ICE_TESTS_CHECK_HPP
+#define ICE_TESTS_CHECK_HPP
+
+#include <cstdlib>
+#include <iostream>
+
+// Fails the test (in every build type, unlike assert) with the location
+#define ICE_CHECK(condition)                                             \
+  do {                                                                   \
+    if (!(condition)) {                                                  \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: "     \
+                << #condition << "\n";                                   \
+      std::exit(EXIT_FAILURE);                                           \
+    }                                                                    \
+  } while (false)
+
+#endif  // ICE_TESTS_CHECK_HPP
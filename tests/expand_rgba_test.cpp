@@ -0,0 +1,56 @@
+#include <array>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "images/ice_expand_rgba.hpp"
+
+namespace {
+// every block size of the RGB kernels (8 and 4 pixels) plus their tails
+constexpr std::size_t MAX_PIXELS = 70;
+constexpr unsigned char GUARD = 0xAB;
+
+// the per pixel expansion the SIMD kernels have to match
+std::array<unsigned char, 4> expected_pixel(const unsigned char *pixel,
+                                            int components) {
+  if (components >= 3) {
+    return {pixel[0], pixel[1], pixel[2],
+            components == 4 ? pixel[3] : static_cast<unsigned char>(255)};
+  }
+  return {pixel[0], pixel[0], pixel[0],
+          components == 2 ? pixel[1] : static_cast<unsigned char>(255)};
+}
+}  // namespace
+
+int main() {
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> byte(0, 255);
+
+  for (int components = 1; components <= 4; ++components) {
+    for (std::size_t pixels = 1; pixels <= MAX_PIXELS; ++pixels) {
+      std::vector<unsigned char> source(pixels * components);
+      for (unsigned char &value : source) {
+        value = static_cast<unsigned char>(byte(rng));
+      }
+      // guard bytes past the end catch stores of a whole block
+      std::vector<unsigned char> rgba(pixels * 4 + 32, GUARD);
+      ice_image::expand_to_rgba(source.data(), components, pixels,
+                                rgba.data());
+
+      for (std::size_t i = 0; i < pixels; ++i) {
+        const std::array<unsigned char, 4> expected =
+            expected_pixel(source.data() + i * components, components);
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+          ICE_CHECK(rgba[i * 4 + channel] == expected[channel]);
+        }
+      }
+      for (std::size_t i = pixels * 4; i < rgba.size(); ++i) {
+        ICE_CHECK(rgba[i] == GUARD);
+      }
+    }
+  }
+
+  std::cout << "expand_to_rgba matches the per pixel expansion\n";
+  return EXIT_SUCCESS;
+}
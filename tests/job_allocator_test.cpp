@@ -0,0 +1,98 @@
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "multithreading/ice_job_allocator.hpp"
+
+namespace {
+constexpr std::size_t JOBS_PER_FRAME = 1000;
+constexpr std::size_t WARM_UP_FRAMES = 10;
+constexpr std::size_t FRAMES = 500;
+
+// The renderer's pattern: one thread makes every frame's jobs, another
+// deletes them.
+class RemoteFreer {
+ public:
+  RemoteFreer() : thread([this] { run(); }) {}
+  ~RemoteFreer() {
+    {
+      const std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+  }
+
+  void free(std::vector<void *> blocks) {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return pending.empty(); });
+    pending = std::move(blocks);
+    changed.notify_all();
+  }
+
+  // blocks until the frame handed over was freed
+  void drain() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return pending.empty() && !freeing; });
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+      changed.wait(guard, [this] { return stopping || !pending.empty(); });
+      if (pending.empty()) {
+        return;
+      }
+      std::vector<void *> blocks = std::move(pending);
+      pending.clear();
+      freeing = true;
+      guard.unlock();
+      changed.notify_all();
+      for (void *block : blocks) {
+        ice_threading::free_job_block(block, 96);
+      }
+      guard.lock();
+      freeing = false;
+      changed.notify_all();
+    }
+  }
+
+  std::mutex lock;
+  std::condition_variable changed;
+  std::vector<void *> pending;
+  bool freeing{false};
+  bool stopping{false};
+  std::thread thread;
+};
+
+void allocate_frames(RemoteFreer &freer, std::size_t frames) {
+  for (std::size_t frame = 0; frame < frames; ++frame) {
+    std::vector<void *> blocks;
+    blocks.reserve(JOBS_PER_FRAME);
+    for (std::size_t i = 0; i < JOBS_PER_FRAME; ++i) {
+      blocks.push_back(ice_threading::allocate_job_block(96));
+    }
+    freer.free(std::move(blocks));
+    freer.drain();
+  }
+}
+}  // namespace
+
+int main() {
+  RemoteFreer freer;
+  allocate_frames(freer, WARM_UP_FRAMES);
+  const std::size_t warm_slabs = ice_threading::job_slab_count();
+
+  allocate_frames(freer, FRAMES);
+  const std::size_t slabs = ice_threading::job_slab_count();
+  std::cout << "slabs after warm-up " << warm_slabs << ", after " << FRAMES
+            << " more frames " << slabs << "\n";
+  // blocks freed on the other thread must come back to the allocating one
+  ICE_CHECK(slabs == warm_slabs);
+  return EXIT_SUCCESS;
+}
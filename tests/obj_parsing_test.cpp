@@ -0,0 +1,43 @@
+#include <string_view>
+
+#include "check.hpp"
+#include "obj_parsing.hpp"
+
+namespace {
+bool equal(const glm::vec3 &a, const glm::vec3 &b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+}  // namespace
+
+// The MTL colors ObjMesh::read_materials assigns the material ids from
+int main() {
+  using ice::obj::read_material_colors;
+
+  // a material with several Kd keeps the first, the file's last Kd colors
+  // the faces before any usemtl
+  const std::string_view duplicated =
+      "newmtl red\r\n"
+      "Kd 1.0 0.0 0.0\r\n"
+      "Kd 0.5 0.5 0.5\r\n"
+      "newmtl green\n"
+      "Ka 0.1 0.1 0.1\n"
+      "Kd 0.0 +1.0 0.0\n"
+      "newmtl red\n"
+      "Kd 0.0 0.0 1.0\n";
+  const ice::obj::MaterialColors materials =
+      read_material_colors(duplicated);
+  ICE_CHECK(materials.names.size() == 2);
+  ICE_CHECK(materials.colors.size() == 2);
+  ICE_CHECK(materials.names[0] == "red");
+  ICE_CHECK(equal(materials.colors[0], {1.0f, 0.0f, 0.0f}));
+  ICE_CHECK(materials.names[1] == "green");
+  ICE_CHECK(equal(materials.colors[1], {0.0f, 1.0f, 0.0f}));
+  ICE_CHECK(materials.last && equal(*materials.last, {0.0f, 0.0f, 1.0f}));
+
+  // materials without Kd get no color
+  const ice::obj::MaterialColors uncolored =
+      read_material_colors("newmtl plain\nNs 10\n");
+  ICE_CHECK(uncolored.names.empty());
+  ICE_CHECK(!uncolored.last);
+  return 0;
+}
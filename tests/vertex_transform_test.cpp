@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "vertex_transform.hpp"
+
+namespace {
+// every block size of the kernels (8 and 4) plus their tails
+constexpr std::size_t MAX_COUNT = 40;
+
+// FMA rounds once where the scalar loop rounds twice
+bool close(const glm::vec3 &kernel, const glm::vec3 &reference) {
+  const glm::vec3 error = glm::abs(kernel - reference);
+  const float tolerance = 1e-5f * (1.0f + glm::length(reference));
+  return error.x <= tolerance && error.y <= tolerance && error.z <= tolerance;
+}
+}  // namespace
+
+// The SIMD kernel compiled in (see ICE_ENABLE_AVX2) against glm's scalar
+// matrix products, which the per-vertex loaders used
+int main() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+
+  glm::mat4 matrix(1.0f);
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 3; ++row) {
+      matrix[column][row] = value(rng);
+    }
+  }
+  const glm::mat3 normal_matrix(matrix);
+
+  for (std::size_t count = 0; count <= MAX_COUNT; ++count) {
+    std::vector<glm::vec3> source(count);
+    for (glm::vec3 &vector : source) {
+      vector = {value(rng), value(rng), value(rng)};
+    }
+    std::vector<glm::vec3> points = source;
+    std::vector<glm::vec3> directions = source;
+    ice::transform_points(matrix, points);
+    ice::transform_directions(normal_matrix, directions);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      const glm::vec3 point(matrix * glm::vec4(source[i], 1.0f));
+      ICE_CHECK(close(points[i], point));
+      ICE_CHECK(close(directions[i], normal_matrix * source[i]));
+    }
+  }
+
+  std::cout << "kernel " << ice::vertex_transform_kernel()
+            << " matches the scalar transforms\n";
+  return EXIT_SUCCESS;
+}
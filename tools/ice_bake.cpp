@@ -0,0 +1,55 @@
+// Bakes image files ahead of time: ice_bake <image>... writes <image>.ktx2
+// with the full mip chain, the same bake the engine writes when it loads an
+// image with ICE_BAKE_TEXTURES=1 (see images/ice_baked_texture.hpp). With
+// the bakes shipped, no start generates the mipmaps.
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <cstdlib>
+#include <format>
+#include <iostream>
+
+#include "images/ice_baked_texture.hpp"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: ice_bake <image>...\n";
+    return EXIT_FAILURE;
+  }
+
+  int failed = 0;
+  for (int i = 1; i < argc; ++i) {
+    const std::string source = argv[i];
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    // decoded like ice_image::Texture decodes image files
+    stbi_uc *pixels = stbi_load(source.c_str(), &width, &height, &channels,
+                                STBI_rgb_alpha);
+    if (pixels == nullptr) {
+      std::cerr << std::format("{}: {}\n", source,
+                               stbi_failure_reason() != nullptr
+                                   ? stbi_failure_reason()
+                                   : "unknown error");
+      ++failed;
+      continue;
+    }
+
+    std::vector<std::vector<unsigned char>> mips;
+    const ice_image::BakedTexture baked = ice_image::make_baked_texture(
+        pixels, static_cast<std::uint32_t>(width),
+        static_cast<std::uint32_t>(height), mips);
+    const bool written = ice_image::write_baked_texture(source, baked);
+    stbi_image_free(pixels);
+    if (!written) {
+      std::cerr << std::format("{}: could not write {}\n", source,
+                               ice_image::baked_texture_path(source));
+      ++failed;
+      continue;
+    }
+    std::cout << std::format("{} -> {} ({} levels)\n", source,
+                             ice_image::baked_texture_path(source),
+                             baked.levels.size());
+  }
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}